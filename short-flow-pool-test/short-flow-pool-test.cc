@@ -0,0 +1,133 @@
+// Check that ShortFlowWorkload carries many short flows over a bounded set of
+// sockets.
+//
+//   s0 ---+                              +--- d0
+//   s1 ---+-- r0 ------------------ r1 --+
+//   s2 ---+       20 Mbps, 5 ms          +--- d1
+//   s3 ---+
+//
+// Short flows of 1 to 100 segments arrive at --load of the bottleneck from
+// random senders s0..s3 to receiver d(i % 2), over --connections persistent
+// connections per sender. The TCP sockets of all nodes are counted twice a
+// second. The program aborts unless thousands of flows complete, no more
+// sockets exist at any time than the two ends of every pooled connection and
+// one listening socket per receiver, and no connection had to be reopened.
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "../tcp-scenario-common/short-flow-workload.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace ns3;
+
+// TCP sockets of all nodes, including those that are closing
+uint32_t
+CountTcpSockets()
+{
+    uint32_t sockets = 0;
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
+    {
+        Ptr<TcpL4Protocol> tcp = NodeList::GetNode(i)->GetObject<TcpL4Protocol>();
+        ObjectVectorValue list;
+        tcp->GetAttribute("SocketList", list);
+        sockets += list.GetN();
+    }
+    return sockets;
+}
+
+void
+SampleSockets(uint32_t* maxSockets, Time interval)
+{
+    *maxSockets = std::max(*maxSockets, CountTcpSockets());
+    Simulator::Schedule(interval, &SampleSockets, maxSockets, interval);
+}
+
+int
+main(int argc, char* argv[])
+{
+    double load = 0.6;
+    uint32_t connections = 4;
+    Time stopTime = Seconds(60);
+    uint64_t minFlows = 1000;
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("load", "Short flow load, a fraction of the bottleneck rate", load);
+    cmd.AddValue("connections", "Persistent connections of every sender", connections);
+    cmd.AddValue("stopTime", "Simulated time", stopTime);
+    cmd.AddValue("minFlows", "Flows that must complete for the check to pass", minFlows);
+    cmd.Parse(argc, argv);
+
+    NodeContainer senders;
+    senders.Create(4);
+    NodeContainer routers;
+    routers.Create(2);
+    NodeContainer receivers;
+    receivers.Create(2);
+    InternetStackHelper stack;
+    stack.InstallAll();
+
+    PointToPointHelper access;
+    access.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+    access.SetChannelAttribute("Delay", StringValue("1ms"));
+    PointToPointHelper bottleneck;
+    bottleneck.SetDeviceAttribute("DataRate", StringValue("20Mbps"));
+    bottleneck.SetChannelAttribute("Delay", StringValue("5ms"));
+
+    Ipv4AddressHelper addresses("10.1.0.0", "255.255.255.252");
+    for (uint32_t i = 0; i < senders.GetN(); ++i)
+    {
+        addresses.Assign(access.Install(senders.Get(i), routers.Get(0)));
+        addresses.NewNetwork();
+    }
+    addresses.Assign(bottleneck.Install(routers.Get(0), routers.Get(1)));
+    addresses.NewNetwork();
+    std::vector<Ipv4Address> receiverAddresses;
+    for (uint32_t i = 0; i < receivers.GetN(); ++i)
+    {
+        Ipv4InterfaceContainer link = addresses.Assign(access.Install(routers.Get(1),
+                                                                      receivers.Get(i)));
+        receiverAddresses.push_back(link.GetAddress(1));
+        addresses.NewNetwork();
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    // 1 to 100 segments, a mean of about 44 kB
+    FlowSizeCdf sizes = {{1460, 0}, {14600, 0.5}, {146000, 1}};
+    ShortFlowWorkload workload(sizes, 40000, connections, true);
+    workload.Install(senders,
+                     receivers,
+                     receiverAddresses,
+                     load,
+                     DataRate("20Mbps"),
+                     Seconds(1.0),
+                     stopTime);
+
+    uint32_t maxSockets = 0;
+    Simulator::Schedule(Seconds(1.0), &SampleSockets, &maxSockets, MilliSeconds(500));
+    Simulator::Stop(stopTime + Seconds(5));
+    Simulator::Run();
+    uint32_t endSockets = CountTcpSockets();
+    Simulator::Destroy();
+
+    workload.Print(std::cout);
+    uint64_t bound = 2 * workload.GetConnectionCount() + receivers.GetN();
+    std::cout << "TCP sockets: at most " << maxSockets << ", " << endSockets
+              << " at the end, bound " << bound << std::endl;
+
+    NS_ABORT_MSG_UNLESS(workload.GetCompletedFlows() >= minFlows,
+                        "Only " << workload.GetCompletedFlows() << " flows completed");
+    NS_ABORT_MSG_UNLESS(workload.GetConnectionCount() == senders.GetN() * connections,
+                        "The connection pool grew to " << workload.GetConnectionCount());
+    NS_ABORT_MSG_UNLESS(workload.GetConnectionAttempts() == workload.GetConnectionCount(),
+                        "Connections were reopened");
+    NS_ABORT_MSG_UNLESS(maxSockets <= bound && endSockets <= bound,
+                        "Socket count exceeded " << bound << " with "
+                                                 << workload.GetCompletedFlows() << " flows");
+    std::cout << "PASS: " << workload.GetCompletedFlows() << " flows over "
+              << workload.GetConnectionCount() << " connections" << std::endl;
+    return 0;
+}
@@ -0,0 +1,374 @@
+#include "adaptive-sweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+
+namespace
+{
+
+// Split "12.5ms" into 12.5 and "ms"
+double
+ParseValue(const std::string& text, std::string& unit)
+{
+    std::size_t end = 0;
+    double value = std::stod(text, &end);
+    unit = text.substr(end);
+    return value;
+}
+
+// Shortest decimal representation with at most 3 decimals, keeping one
+// decimal like the delays in parameters.csv (e.g. 6.25, 50.0)
+std::string
+FormatDecimal(double value, bool keepDecimal)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    std::string text = buffer;
+    text.erase(text.find_last_not_of('0') + 1);
+    if (text.back() == '.')
+    {
+        if (keepDecimal)
+        {
+            text += '0';
+        }
+        else
+        {
+            text.pop_back();
+        }
+    }
+    return text;
+}
+
+// value rounded to 3 significant digits
+double
+RoundSignificant(double value)
+{
+    double scale = std::pow(10.0, 2 - std::floor(std::log10(value)));
+    return std::round(value * scale) / scale;
+}
+
+// Element of the sorted values strictly between lo and hi closest to their
+// geometric mean, or empty
+std::string
+MiddleOf(const std::vector<std::string>& values,
+         double (*parse)(const std::string&),
+         const std::string& lo,
+         const std::string& hi)
+{
+    double low = parse(lo);
+    double high = parse(hi);
+    double mid = std::sqrt(low * high);
+    std::string best;
+    double bestDistance = INFINITY;
+    for (const std::string& value : values)
+    {
+        double v = parse(value);
+        if (v > low && v < high && std::abs(std::log(v / mid)) < bestDistance)
+        {
+            best = value;
+            bestDistance = std::abs(std::log(v / mid));
+        }
+    }
+    return best;
+}
+
+// Every stride-th value, including the last one
+std::vector<std::string>
+Thin(const std::vector<std::string>& values, uint32_t stride)
+{
+    std::vector<std::string> thinned;
+    for (std::size_t i = 0; i < values.size(); i += stride)
+    {
+        thinned.push_back(values[i]);
+    }
+    if (!values.empty() && thinned.back() != values.back())
+    {
+        thinned.push_back(values.back());
+    }
+    return thinned;
+}
+
+} // namespace
+
+double
+ParseBandwidth(const std::string& bandwidth)
+{
+    std::string unit;
+    double value = ParseValue(bandwidth, unit);
+    if (unit == "bps")
+    {
+        return value;
+    }
+    if (unit == "kbps" || unit == "Kbps")
+    {
+        return value * 1e3;
+    }
+    if (unit == "Mbps")
+    {
+        return value * 1e6;
+    }
+    if (unit == "Gbps")
+    {
+        return value * 1e9;
+    }
+    throw std::invalid_argument("Unknown bandwidth unit in " + bandwidth);
+}
+
+double
+ParseDelay(const std::string& delay)
+{
+    std::string unit;
+    double value = ParseValue(delay, unit);
+    if (unit == "s")
+    {
+        return value;
+    }
+    if (unit == "ms")
+    {
+        return value * 1e-3;
+    }
+    if (unit == "us")
+    {
+        return value * 1e-6;
+    }
+    throw std::invalid_argument("Unknown delay unit in " + delay);
+}
+
+std::string
+FormatBandwidth(double bitsPerSecond)
+{
+    return FormatDecimal(RoundSignificant(bitsPerSecond / 1e6), false) + "Mbps";
+}
+
+std::string
+FormatDelay(double seconds)
+{
+    return FormatDecimal(RoundSignificant(seconds * 1e3), true) + "ms";
+}
+
+AdaptiveGrid::AdaptiveGrid(const std::vector<GridPoint>& fullGrid,
+                           uint32_t coarseStride,
+                           double minRatio,
+                           double varianceThreshold)
+    : m_coarseStride(std::max<uint32_t>(coarseStride, 1)),
+      m_minRatio(minRatio),
+      m_varianceThreshold(varianceThreshold)
+{
+    std::set<std::string> qdiscSizes;
+    std::map<double, std::string> bandwidths;
+    std::map<double, std::string> delays;
+    for (const GridPoint& point : fullGrid)
+    {
+        qdiscSizes.insert(point.qdiscSize);
+        bandwidths.emplace(ParseBandwidth(point.bandwidth), point.bandwidth);
+        delays.emplace(ParseDelay(point.delay), point.delay);
+    }
+    m_qdiscSizes.assign(qdiscSizes.begin(), qdiscSizes.end());
+    for (const auto& [value, text] : bandwidths)
+    {
+        m_bandwidths.push_back(text);
+    }
+    for (const auto& [value, text] : delays)
+    {
+        m_delays.push_back(text);
+    }
+
+    std::vector<std::string> b = Thin(m_bandwidths, m_coarseStride);
+    std::vector<std::string> d = Thin(m_delays, m_coarseStride);
+    for (const std::string& qdiscSize : m_qdiscSizes)
+    {
+        for (std::size_t i = 0; i + 1 < b.size(); ++i)
+        {
+            for (std::size_t j = 0; j + 1 < d.size(); ++j)
+            {
+                m_cells.push_back({qdiscSize, b[i], b[i + 1], d[j], d[j + 1]});
+            }
+        }
+    }
+}
+
+std::vector<GridPoint>
+AdaptiveGrid::GetCoarsePoints() const
+{
+    std::vector<GridPoint> points;
+    for (const std::string& qdiscSize : m_qdiscSizes)
+    {
+        for (const std::string& bandwidth : Thin(m_bandwidths, m_coarseStride))
+        {
+            for (const std::string& delay : Thin(m_delays, m_coarseStride))
+            {
+                points.push_back({qdiscSize, bandwidth, delay});
+            }
+        }
+    }
+    return points;
+}
+
+void
+AdaptiveGrid::SetGain(const GridPoint& point, double mean, double halfWidth, uint32_t samples)
+{
+    m_gains[point] = {mean, halfWidth, samples};
+}
+
+std::string
+AdaptiveGrid::SplitBandwidth(const std::string& lo, const std::string& hi) const
+{
+    std::string middle = MiddleOf(m_bandwidths, &ParseBandwidth, lo, hi);
+    double low = ParseBandwidth(lo);
+    double high = ParseBandwidth(hi);
+    if (middle.empty() && high / low >= m_minRatio)
+    {
+        middle = FormatBandwidth(std::sqrt(low * high));
+    }
+    // Rounding may have moved it onto an edge
+    if (!middle.empty() && (ParseBandwidth(middle) <= low || ParseBandwidth(middle) >= high))
+    {
+        middle.clear();
+    }
+    return middle;
+}
+
+std::string
+AdaptiveGrid::SplitDelay(const std::string& lo, const std::string& hi) const
+{
+    std::string middle = MiddleOf(m_delays, &ParseDelay, lo, hi);
+    double low = ParseDelay(lo);
+    double high = ParseDelay(hi);
+    if (middle.empty() && high / low >= m_minRatio)
+    {
+        middle = FormatDelay(std::sqrt(low * high));
+    }
+    if (!middle.empty() && (ParseDelay(middle) <= low || ParseDelay(middle) >= high))
+    {
+        middle.clear();
+    }
+    return middle;
+}
+
+int
+AdaptiveGrid::Classify(const Cell& cell) const
+{
+    double lowest = INFINITY;
+    double highest = -INFINITY;
+    bool uncertain = false;
+    for (const std::string& b : {cell.b0, cell.b1})
+    {
+        for (const std::string& d : {cell.d0, cell.d1})
+        {
+            auto it = m_gains.find({cell.qdiscSize, b, d});
+            if (it == m_gains.end())
+            {
+                return -1;
+            }
+            const Gain& gain = it->second;
+            lowest = std::min(lowest, gain.mean);
+            highest = std::max(highest, gain.mean);
+            uncertain = uncertain || gain.samples < 2 ||
+                        gain.halfWidth > m_varianceThreshold * std::abs(gain.mean);
+        }
+    }
+    if (lowest < 0 && highest > 0)
+    {
+        return 2;
+    }
+    return uncertain ? 1 : 0;
+}
+
+std::vector<GridPoint>
+AdaptiveGrid::Refine(const std::function<bool(const std::vector<GridPoint>&)>& admit)
+{
+    // Order of refinement: priority, then size of the cell in the log plane
+    struct Candidate
+    {
+        int priority;
+        double area;
+        std::size_t cell;
+    };
+    std::vector<Candidate> candidates;
+    for (std::size_t i = 0; i < m_cells.size(); ++i)
+    {
+        const Cell& c = m_cells[i];
+        int priority = Classify(c);
+        if (priority > 0)
+        {
+            double area = std::log(ParseBandwidth(c.b1) / ParseBandwidth(c.b0)) *
+                          std::log(ParseDelay(c.d1) / ParseDelay(c.d0));
+            candidates.push_back({priority, area, i});
+        }
+    }
+    std::stable_sort(candidates.begin(),
+                     candidates.end(),
+                     [](const Candidate& a, const Candidate& b) {
+                         return a.priority != b.priority ? a.priority > b.priority
+                                                         : a.area > b.area;
+                     });
+
+    std::set<GridPoint> admitted;
+    std::vector<Cell> split;
+    std::vector<bool> done(m_cells.size(), false);
+    for (const Candidate& candidate : candidates)
+    {
+        const Cell c = m_cells[candidate.cell];
+        std::string bm = SplitBandwidth(c.b0, c.b1);
+        std::string dm = SplitDelay(c.d0, c.d1);
+        if (bm.empty() && dm.empty())
+        {
+            continue;
+        }
+        std::vector<std::string> bs = {c.b0, c.b1};
+        std::vector<std::string> ds = {c.d0, c.d1};
+        if (!bm.empty())
+        {
+            bs.insert(bs.begin() + 1, bm);
+        }
+        if (!dm.empty())
+        {
+            ds.insert(ds.begin() + 1, dm);
+        }
+        std::vector<GridPoint> points;
+        for (const std::string& b : bs)
+        {
+            for (const std::string& d : ds)
+            {
+                GridPoint p{c.qdiscSize, b, d};
+                if (m_gains.count(p) == 0 && admitted.count(p) == 0)
+                {
+                    points.push_back(p);
+                }
+            }
+        }
+        if (!admit(points))
+        {
+            continue;
+        }
+        admitted.insert(points.begin(), points.end());
+        done[candidate.cell] = true;
+        for (std::size_t i = 0; i + 1 < bs.size(); ++i)
+        {
+            for (std::size_t j = 0; j + 1 < ds.size(); ++j)
+            {
+                split.push_back({c.qdiscSize, bs[i], bs[i + 1], ds[j], ds[j + 1]});
+            }
+        }
+    }
+
+    std::vector<Cell> cells;
+    for (std::size_t i = 0; i < m_cells.size(); ++i)
+    {
+        if (!done[i])
+        {
+            cells.push_back(m_cells[i]);
+        }
+    }
+    cells.insert(cells.end(), split.begin(), split.end());
+    m_cells = cells;
+    // Cells whose new corners were all known already are refined further
+    if (admitted.empty() && !split.empty())
+    {
+        return Refine(admit);
+    }
+    return std::vector<GridPoint>(admitted.begin(), admitted.end());
+}
@@ -0,0 +1,95 @@
+#ifndef ADAPTIVE_SWEEP_H
+#define ADAPTIVE_SWEEP_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// One bandwidth/delay point of a sweep, in the notation of parameters.csv
+struct GridPoint
+{
+    std::string qdiscSize;
+    std::string bandwidth; // e.g. 250Mbps
+    std::string delay;     // e.g. 12.5ms
+
+    bool operator<(const GridPoint& other) const
+    {
+        return std::tie(qdiscSize, bandwidth, delay) <
+               std::tie(other.qdiscSize, other.bandwidth, other.delay);
+    }
+};
+
+// Parse "250Mbps" to bit/s and "12.5ms" to seconds
+double ParseBandwidth(const std::string& bandwidth);
+double ParseDelay(const std::string& delay);
+// Format with 3 significant digits, e.g. 158Mbps and 1.77ms
+std::string FormatBandwidth(double bitsPerSecond);
+std::string FormatDelay(double seconds);
+
+// Bandwidth x delay plane of every buffer size, refined where the goodput gain
+// of BBR over Cubic is interesting.
+//
+// The plane starts as a coarse grid taking every coarseStride-th bandwidth
+// and delay of the full grid (always including both ends). Its cells are
+// refined where the gain changes sign between the corners, or where a corner
+// is uncertain (the confidence half-width across trials is more than
+// varianceThreshold times the magnitude of the gain, or there are fewer than
+// two trials to estimate it from). A cell is split at the
+// full grid values inside it, or at the geometric mean of its edges once
+// there are none left, until the edges are less than minRatio apart.
+class AdaptiveGrid
+{
+  public:
+    AdaptiveGrid(const std::vector<GridPoint>& fullGrid,
+                 uint32_t coarseStride,
+                 double minRatio,
+                 double varianceThreshold);
+
+    std::vector<GridPoint> GetCoarsePoints() const;
+
+    // Gain of BBR over Cubic at a point, in Mbps, over samples trials
+    void SetGain(const GridPoint& point, double mean, double halfWidth, uint32_t samples);
+
+    // Split the cells that need refinement, the most important first: cells
+    // with a sign change, then uncertain cells, larger cells first. admit is
+    // called with the new points of each cell and decides whether to split it
+    // (e.g. whether they fit in the remaining budget). Returns the admitted
+    // points, empty once nothing is left to refine.
+    std::vector<GridPoint> Refine(
+        const std::function<bool(const std::vector<GridPoint>&)>& admit);
+
+  private:
+    struct Cell
+    {
+        std::string qdiscSize;
+        std::string b0, b1; // bandwidth edges
+        std::string d0, d1; // delay edges
+    };
+    struct Gain
+    {
+        double mean;
+        double halfWidth;
+        uint32_t samples;
+    };
+
+    // Value strictly between lo and hi to split an edge at, empty if the edge
+    // is too short
+    std::string SplitBandwidth(const std::string& lo, const std::string& hi) const;
+    std::string SplitDelay(const std::string& lo, const std::string& hi) const;
+    // 2 = sign change, 1 = uncertain, 0 = settled, -1 = corners not evaluated
+    int Classify(const Cell& cell) const;
+
+    std::vector<std::string> m_bandwidths; // sorted full grid values
+    std::vector<std::string> m_delays;
+    std::vector<std::string> m_qdiscSizes;
+    uint32_t m_coarseStride;
+    double m_minRatio;
+    double m_varianceThreshold;
+    std::vector<Cell> m_cells;
+    std::map<GridPoint, Gain> m_gains;
+};
+
+#endif /* ADAPTIVE_SWEEP_H */
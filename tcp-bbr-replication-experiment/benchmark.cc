@@ -0,0 +1,218 @@
+#include "benchmark.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+void
+WriteRunStats(const std::string& file, const RunStats& stats)
+{
+    // Written under a temporary name and renamed, so that a crash never
+    // leaves a partial file behind
+    std::string tmpFile = file + ".tmp";
+    std::ofstream out(tmpFile);
+    out << "wallSeconds " << stats.wallSeconds << "\n";
+    out << "runWallSeconds " << stats.runWallSeconds << "\n";
+    out << "events " << stats.events << "\n";
+    out << "simulatedSeconds " << stats.simulatedSeconds << "\n";
+    out << "peakRssKb " << stats.peakRssKb << "\n";
+    out << "traceBytes " << stats.traceBytes << "\n";
+    out << "setupWallSeconds " << stats.setupWallSeconds << "\n";
+    out << "setupRssKb " << stats.setupRssKb << "\n";
+    out << "aborted " << stats.aborted << "\n";
+    out.close();
+    std::filesystem::rename(tmpFile, file);
+}
+
+bool
+ReadRunStats(const std::string& file, RunStats& stats)
+{
+    std::ifstream in(file);
+    if (!in.is_open())
+    {
+        return false;
+    }
+    std::string key;
+    while (in >> key)
+    {
+        if (key == "wallSeconds")
+        {
+            in >> stats.wallSeconds;
+        }
+        else if (key == "runWallSeconds")
+        {
+            in >> stats.runWallSeconds;
+        }
+        else if (key == "events")
+        {
+            in >> stats.events;
+        }
+        else if (key == "simulatedSeconds")
+        {
+            in >> stats.simulatedSeconds;
+        }
+        else if (key == "peakRssKb")
+        {
+            in >> stats.peakRssKb;
+        }
+        else if (key == "traceBytes")
+        {
+            in >> stats.traceBytes;
+        }
+        else if (key == "setupWallSeconds")
+        {
+            in >> stats.setupWallSeconds;
+        }
+        else if (key == "setupRssKb")
+        {
+            in >> stats.setupRssKb;
+        }
+        else if (key == "aborted")
+        {
+            in >> stats.aborted;
+        }
+        else
+        {
+            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+    }
+    return true;
+}
+
+uint64_t
+GetDirectorySize(const std::string& dir)
+{
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, ec))
+    {
+        if (entry.is_regular_file(ec))
+        {
+            total += entry.file_size(ec);
+        }
+    }
+    return total;
+}
+
+void
+WriteBenchmarkResults(const std::string& file, const BenchmarkResults& results)
+{
+    std::ofstream out(file);
+    out << "name,wall_s,run_wall_s,events,events_per_s,sim_per_wall,peak_rss_kb,trace_bytes,"
+           "setup_s,setup_rss_kb\n";
+    for (const auto& entry : results)
+    {
+        const RunStats& s = entry.second;
+        out << entry.first << "," << s.wallSeconds << "," << s.runWallSeconds << "," << s.events
+            << "," << (s.runWallSeconds > 0 ? s.events / s.runWallSeconds : 0) << ","
+            << (s.runWallSeconds > 0 ? s.simulatedSeconds / s.runWallSeconds : 0) << ","
+            << s.peakRssKb << "," << s.traceBytes << "," << s.setupWallSeconds << ","
+            << s.setupRssKb << "\n";
+    }
+}
+
+BenchmarkResults
+ReadBenchmarkResults(const std::string& file)
+{
+    BenchmarkResults results;
+    std::ifstream in(file);
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line))
+    {
+        std::stringstream ss(line);
+        std::string name;
+        std::string field;
+        std::vector<std::string> fields;
+        std::getline(ss, name, ',');
+        while (std::getline(ss, field, ','))
+        {
+            fields.push_back(field);
+        }
+        if (name.empty() || fields.size() < 7)
+        {
+            continue;
+        }
+        RunStats s;
+        s.wallSeconds = std::stod(fields[0]);
+        s.runWallSeconds = std::stod(fields[1]);
+        s.events = std::stoull(fields[2]);
+        // events_per_s and sim_per_wall are derived
+        s.simulatedSeconds = std::stod(fields[4]) * s.runWallSeconds;
+        s.peakRssKb = std::stoull(fields[5]);
+        s.traceBytes = std::stoull(fields[6]);
+        // Not in results of older versions
+        if (fields.size() >= 9)
+        {
+            s.setupWallSeconds = std::stod(fields[7]);
+            s.setupRssKb = std::stoull(fields[8]);
+        }
+        results[name] = s;
+    }
+    return results;
+}
+
+uint32_t
+CompareWithBaseline(const BenchmarkResults& baseline,
+                    const BenchmarkResults& current,
+                    double threshold)
+{
+    struct Metric
+    {
+        const char* name;
+        double (*get)(const RunStats&);
+        bool higherIsBetter;
+    };
+
+    const Metric metrics[] = {
+        {"wall_s", [](const RunStats& s) { return s.wallSeconds; }, false},
+        {"events_per_s",
+         [](const RunStats& s) { return s.runWallSeconds > 0 ? s.events / s.runWallSeconds : 0; },
+         true},
+        {"peak_rss_kb", [](const RunStats& s) { return double(s.peakRssKb); }, false},
+        {"trace_bytes", [](const RunStats& s) { return double(s.traceBytes); }, false},
+    };
+
+    uint32_t regressions = 0;
+    std::cout << std::left << std::setw(44) << "case" << std::setw(14) << "metric" << std::right
+              << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10)
+              << "change" << "\n";
+    for (const auto& entry : current)
+    {
+        auto base = baseline.find(entry.first);
+        if (base == baseline.end())
+        {
+            std::cout << std::left << std::setw(44) << entry.first << "not in baseline\n";
+            continue;
+        }
+        for (const Metric& metric : metrics)
+        {
+            double before = metric.get(base->second);
+            double after = metric.get(entry.second);
+            double change = before > 0 ? (after - before) / before : 0;
+            bool worse = metric.higherIsBetter ? change < -threshold : change > threshold;
+            std::cout << std::left << std::setw(44) << entry.first << std::setw(14) << metric.name
+                      << std::right << std::setw(14) << before << std::setw(14) << after
+                      << std::setw(9) << std::fixed << std::setprecision(1) << 100 * change << "%"
+                      << std::defaultfloat << std::setprecision(6)
+                      << (worse ? "  REGRESSION" : "") << "\n";
+            if (worse)
+            {
+                regressions++;
+            }
+        }
+    }
+    for (const auto& entry : baseline)
+    {
+        if (current.find(entry.first) == current.end())
+        {
+            std::cout << std::left << std::setw(44) << entry.first << "missing from this run\n";
+        }
+    }
+    std::cout << regressions << " regression(s) beyond " << 100 * threshold << "%" << std::endl;
+    return regressions;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Cost of one simulation run, written to run-stats.txt next to its results
+struct RunStats
+{
+    double wallSeconds{0};      // whole run: setup, event loop and result files
+    double runWallSeconds{0};   // Simulator::Run() only
+    uint64_t events{0};         // events executed
+    double simulatedSeconds{0}; // simulated time covered
+    uint64_t peakRssKb{0};      // peak resident memory of the run (see ResetPeakRss)
+    uint64_t traceBytes{0};     // size of everything written to the result directory
+    double setupWallSeconds{0}; // topology, applications and tracing, before Simulator::Run()
+    uint64_t setupRssKb{0};     // peak resident memory when the setup was done
+    bool aborted{false};        // stopped early by the watchdog, results are partial
+};
+
+// Replaces file atomically
+void WriteRunStats(const std::string& file, const RunStats& stats);
+bool ReadRunStats(const std::string& file, RunStats& stats);
+
+// Total size of the files below dir
+uint64_t GetDirectorySize(const std::string& dir);
+
+// Benchmark results, one line per case, keyed by case name
+using BenchmarkResults = std::map<std::string, RunStats>;
+
+// Machine-readable CSV: name,wall_s,run_wall_s,events,events_per_s,sim_per_wall,peak_rss_kb,
+// trace_bytes,setup_s,setup_rss_kb
+void WriteBenchmarkResults(const std::string& file, const BenchmarkResults& results);
+BenchmarkResults ReadBenchmarkResults(const std::string& file);
+
+// Print a comparison of every case and metric with the baseline and return
+// how many got worse by more than threshold (a fraction, 0.1 = 10%). Cases
+// missing from either side are reported but not counted.
+uint32_t CompareWithBaseline(const BenchmarkResults& baseline,
+                             const BenchmarkResults& current,
+                             double threshold);
+
+#endif /* BENCHMARK_H */
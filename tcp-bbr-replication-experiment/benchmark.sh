@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Performance benchmark over the representative cells in benchmark.csv
+ROOT_DIR=`pwd`
+CSV_FILE="${ROOT_DIR}/benchmark.csv"
+PATH=$PATH:"/home/ubuntu/source/ns-3.42/"
+OUTPUT_DIR="${ROOT_DIR}/benchmark-results/"
+# Results of an earlier run to compare with (e.g. a copy of benchmark-results.csv)
+BASELINE="${ROOT_DIR}/benchmark-baseline.csv"
+# Flag changes for the worse beyond this fraction
+THRESHOLD=0.1
+
+COMMAND="ns3 run \"tcp-bbr-replication.cc --benchmark=${CSV_FILE} --dir=${OUTPUT_DIR} --regressionThreshold=${THRESHOLD}"
+if [ -f "$BASELINE" ]; then
+	COMMAND="${COMMAND} --baseline=${BASELINE}"
+fi
+COMMAND="${COMMAND}\""
+
+echo "Running: $COMMAND"
+eval $COMMAND
@@ -0,0 +1,127 @@
+#include "convergence-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ns3;
+
+ConvergenceController::ConvergenceController(ApplicationContainer sinks,
+                                             const QueueOccupancyTracker* queue,
+                                             Time window,
+                                             uint32_t batches,
+                                             double tolerance,
+                                             double queueTolerance,
+                                             Time minTime)
+    : m_sinks(sinks),
+      m_queue(queue),
+      m_window(window),
+      m_batches(batches < 2 ? 2 : batches),
+      m_tolerance(tolerance),
+      m_queueTolerance(queueTolerance),
+      m_minTime(minTime)
+{
+    NS_ABORT_MSG_UNLESS(window.IsStrictlyPositive(), "Convergence window must be positive");
+}
+
+void
+ConvergenceController::Start(Time at)
+{
+    Simulator::Schedule(at, &ConvergenceController::Begin, this);
+}
+
+void
+ConvergenceController::Begin()
+{
+    m_lastCheck = Simulator::Now();
+    m_lastRx = GetTotalRx();
+    m_lastQueueArea = m_queue->GetArea();
+    Simulator::Schedule(m_window, &ConvergenceController::Check, this);
+}
+
+void
+ConvergenceController::Check()
+{
+    Time now = Simulator::Now();
+    double seconds = (now - m_lastCheck).GetSeconds();
+    uint64_t rx = GetTotalRx();
+    long double area = m_queue->GetArea();
+    m_goodput.push_back((rx - m_lastRx) * 8.0 / seconds / 1e6);
+    m_queueMean.push_back(
+        static_cast<double>((area - m_lastQueueArea) / (now - m_lastCheck).GetNanoSeconds()));
+    m_lastCheck = now;
+    m_lastRx = rx;
+    m_lastQueueArea = area;
+
+    if (now >= m_minTime && m_goodput.size() >= m_batches)
+    {
+        ConfidenceInterval goodput = EstimateLast(m_goodput);
+        bool settled = goodput.mean > 0 && goodput.halfWidth / goodput.mean < m_tolerance;
+        if (settled && m_queueTolerance > 0)
+        {
+            ConfidenceInterval queue = EstimateLast(m_queueMean);
+            // An empty queue has settled as well
+            settled = queue.mean == 0 || queue.halfWidth / queue.mean < m_queueTolerance;
+        }
+        if (settled)
+        {
+            m_converged = true;
+            Simulator::Stop();
+            return;
+        }
+    }
+    Simulator::Schedule(m_window, &ConvergenceController::Check, this);
+}
+
+ConfidenceInterval
+ConvergenceController::EstimateLast(const std::vector<double>& values) const
+{
+    return EstimateMean(values.end() - m_batches, values.end());
+}
+
+uint64_t
+ConvergenceController::GetTotalRx() const
+{
+    uint64_t rx = 0;
+    for (auto i = m_sinks.Begin(); i != m_sinks.End(); ++i)
+    {
+        rx += DynamicCast<PacketSink>(*i)->GetTotalRx();
+    }
+    return rx;
+}
+
+bool
+ConvergenceController::HasConverged() const
+{
+    return m_converged;
+}
+
+Time
+ConvergenceController::GetWindowStart() const
+{
+    std::size_t n = std::min<std::size_t>(m_batches, m_goodput.size());
+    return m_lastCheck - m_window * static_cast<int64_t>(n);
+}
+
+Time
+ConvergenceController::GetWindowEnd() const
+{
+    return m_lastCheck;
+}
+
+void
+ConvergenceController::Print(std::ostream& os) const
+{
+    os << "Steady state: " << (m_converged ? "converged" : "not converged") << " at "
+       << GetWindowEnd().GetSeconds() << " s\n";
+    if (m_goodput.size() < m_batches)
+    {
+        return;
+    }
+    ConfidenceInterval goodput = EstimateLast(m_goodput);
+    ConfidenceInterval queue = EstimateLast(m_queueMean);
+    os << "  Measurement Window: " << GetWindowStart().GetSeconds() << " - "
+       << GetWindowEnd().GetSeconds() << " s\n";
+    os << "  Steady-State Goodput: " << goodput.mean << " +/- " << goodput.halfWidth
+       << " Mbps (95% CI)\n";
+    os << "  Steady-State Queue: " << queue.mean << " +/- " << queue.halfWidth << " (95% CI)\n";
+}
@@ -0,0 +1,69 @@
+#ifndef CONVERGENCE_CONTROLLER_H
+#define CONVERGENCE_CONTROLLER_H
+
+#include "queue-tracker.h"
+#include "statistics.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+
+#include <ostream>
+#include <vector>
+
+// Stops the simulation once the goodput has reached a steady state.
+//
+// Every window, the goodput received by the PacketSinks (of all flows) and the time-average
+// queue occupancy over that window are recorded as one batch. Once at least
+// minTime has been simulated, the last `batches` batch means are taken as
+// samples of the steady-state goodput; when the half-width of their 95%
+// confidence interval is below tolerance (relative to the mean) the simulation
+// is stopped. If queueTolerance is positive the queue occupancy must have
+// settled in the same way. The run is never longer than its stopTime.
+class ConvergenceController
+{
+  public:
+    ConvergenceController(ns3::ApplicationContainer sinks,
+                          const QueueOccupancyTracker* queue,
+                          ns3::Time window,
+                          uint32_t batches,
+                          double tolerance,
+                          double queueTolerance,
+                          ns3::Time minTime);
+
+    // Start recording batches at the given time (when the flow starts)
+    void Start(ns3::Time at);
+
+    bool HasConverged() const;
+
+    // Measurement window of the steady-state estimate: the last `batches`
+    // windows before the simulation stopped
+    ns3::Time GetWindowStart() const;
+    ns3::Time GetWindowEnd() const;
+
+    // Lines for goodput_retransmission_results.txt
+    void Print(std::ostream& os) const;
+
+  private:
+    void Begin();
+    void Check();
+    uint64_t GetTotalRx() const;
+    // Mean and 95% confidence interval of the last m_batches values
+    ConfidenceInterval EstimateLast(const std::vector<double>& values) const;
+
+    ns3::ApplicationContainer m_sinks;
+    const QueueOccupancyTracker* m_queue;
+    ns3::Time m_window;
+    uint32_t m_batches;
+    double m_tolerance;
+    double m_queueTolerance;
+    ns3::Time m_minTime;
+
+    ns3::Time m_lastCheck;
+    uint64_t m_lastRx{0};
+    long double m_lastQueueArea{0};
+    std::vector<double> m_goodput; // Mbps per window
+    std::vector<double> m_queueMean;
+    bool m_converged{false};
+};
+
+#endif /* CONVERGENCE_CONTROLLER_H */
@@ -0,0 +1,207 @@
+#include "dumbbell-topology.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+namespace
+{
+
+// Source of the delays of a group of access links
+class DelaySource
+{
+  public:
+    explicit DelaySource(const std::string& spec)
+    {
+        if (spec.rfind("ns3::", 0) == 0)
+        {
+            ObjectFactory factory;
+            std::istringstream is(spec);
+            is >> factory;
+            m_random = factory.Create<RandomVariableStream>();
+            NS_ABORT_MSG_UNLESS(m_random, "Not a random variable: " << spec);
+        }
+        else
+        {
+            m_fixed = Time(spec);
+        }
+    }
+
+    Time Next()
+    {
+        return m_random ? MilliSeconds(m_random->GetValue()) : m_fixed;
+    }
+
+  private:
+    Ptr<RandomVariableStream> m_random;
+    Time m_fixed;
+};
+
+uint32_t
+GetInterface(Ptr<NetDevice> device)
+{
+    return device->GetNode()->GetObject<Ipv4>()->GetInterfaceForDevice(device);
+}
+
+void
+AddDefaultRoute(Ptr<NetDevice> device, Ipv4Address gateway)
+{
+    Ipv4StaticRoutingHelper helper;
+    helper.GetStaticRouting(device->GetNode()->GetObject<Ipv4>())
+        ->SetDefaultRoute(gateway, GetInterface(device));
+}
+
+void
+AddSenderRoute(Ptr<NetDevice> device, Ipv4Address gateway)
+{
+    Ipv4StaticRoutingHelper helper;
+    helper.GetStaticRouting(device->GetNode()->GetObject<Ipv4>())
+        ->AddNetworkRouteTo("10.1.0.0", "255.255.0.0", gateway, GetInterface(device));
+}
+
+} // namespace
+
+DumbbellTopology::DumbbellTopology(const DumbbellConfig& config)
+{
+    NS_ABORT_MSG_UNLESS(config.senders > 0 && config.receivers > 0 && config.bottleneckHops > 0,
+                        "A dumbbell needs senders, receivers and a bottleneck");
+    bool receiverRouter = config.receivers > 1;
+    m_routers.Create(config.bottleneckHops + (receiverRouter ? 1 : 0));
+    m_senders.Create(config.senders);
+    m_receivers.Create(config.receivers);
+
+    // Static routing only; global routing would never be populated
+    Ipv4StaticRoutingHelper staticRouting;
+    InternetStackHelper internetStack;
+    internetStack.SetRoutingHelper(staticRouting);
+    internetStack.Install(m_routers);
+    internetStack.Install(m_senders);
+    internetStack.Install(m_receivers);
+
+    PointToPointHelper accessLink;
+    accessLink.SetDeviceAttribute("DataRate", StringValue(config.accessRate));
+
+    PointToPointHelper bottleneckLink;
+    bottleneckLink.SetDeviceAttribute("DataRate", StringValue(config.bottleneckRate));
+    bottleneckLink.SetChannelAttribute("Delay", StringValue(config.bottleneckDelay));
+    bottleneckLink.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("1p")));
+
+    Ptr<Node> firstRouter = m_routers.Get(0);
+    Time maxSenderDelay;
+    Time maxReceiverDelay;
+    DelaySource senderDelay(config.senderDelay);
+    Ipv4AddressHelper senderAddresses("10.1.0.0", "255.255.255.252");
+    for (uint32_t i = 0; i < config.senders; ++i)
+    {
+        Time delay = senderDelay.Next();
+        maxSenderDelay = Max(maxSenderDelay, delay);
+        accessLink.SetChannelAttribute("Delay", TimeValue(delay));
+        NetDeviceContainer link = accessLink.Install(m_senders.Get(i), firstRouter);
+        Ipv4InterfaceContainer addresses = senderAddresses.Assign(link);
+        senderAddresses.NewNetwork();
+        AddDefaultRoute(link.Get(0), addresses.GetAddress(1));
+        m_senderGateways.Add(link.Get(1));
+    }
+
+    Ipv4AddressHelper bottleneckAddresses("10.2.0.0", "255.255.255.252");
+    for (uint32_t hop = 0; hop < config.bottleneckHops; ++hop)
+    {
+        bool last = hop + 1 == config.bottleneckHops;
+        Ptr<Node> next = !last || receiverRouter ? m_routers.Get(hop + 1) : m_receivers.Get(0);
+        NetDeviceContainer link = bottleneckLink.Install(m_routers.Get(hop), next);
+        Ipv4InterfaceContainer addresses = bottleneckAddresses.Assign(link);
+        bottleneckAddresses.NewNetwork();
+        AddDefaultRoute(link.Get(0), addresses.GetAddress(1));
+        if (next == m_receivers.Get(0))
+        {
+            // The single receiver sits on the bottleneck link itself
+            AddDefaultRoute(link.Get(1), addresses.GetAddress(0));
+            m_receiverAddresses.push_back(addresses.GetAddress(1));
+        }
+        else
+        {
+            AddSenderRoute(link.Get(1), addresses.GetAddress(0));
+        }
+        m_bottlenecks.Add(link.Get(0));
+    }
+
+    if (receiverRouter)
+    {
+        Ptr<Node> lastRouter = m_routers.Get(config.bottleneckHops);
+        DelaySource receiverDelay(config.receiverDelay);
+        Ipv4AddressHelper receiverAddresses("10.3.0.0", "255.255.255.252");
+        for (uint32_t i = 0; i < config.receivers; ++i)
+        {
+            Time delay = receiverDelay.Next();
+            maxReceiverDelay = Max(maxReceiverDelay, delay);
+            accessLink.SetChannelAttribute("Delay", TimeValue(delay));
+            NetDeviceContainer link = accessLink.Install(lastRouter, m_receivers.Get(i));
+            Ipv4InterfaceContainer addresses = receiverAddresses.Assign(link);
+            receiverAddresses.NewNetwork();
+            AddDefaultRoute(link.Get(1), addresses.GetAddress(0));
+            m_receiverAddresses.push_back(addresses.GetAddress(1));
+        }
+    }
+    Time oneWay = maxSenderDelay + Time(config.bottleneckDelay) * int64_t(config.bottleneckHops) +
+                  maxReceiverDelay;
+    m_maxPropagationRtt = oneWay * int64_t(2);
+}
+
+Time
+DumbbellTopology::GetMaxPropagationRtt() const
+{
+    return m_maxPropagationRtt;
+}
+
+NodeContainer
+DumbbellTopology::GetSenders() const
+{
+    return m_senders;
+}
+
+NodeContainer
+DumbbellTopology::GetReceivers() const
+{
+    return m_receivers;
+}
+
+NodeContainer
+DumbbellTopology::GetRouters() const
+{
+    return m_routers;
+}
+
+Ipv4Address
+DumbbellTopology::GetReceiverAddress(uint32_t i) const
+{
+    return m_receiverAddresses.at(i);
+}
+
+NetDeviceContainer
+DumbbellTopology::GetSenderGatewayDevices() const
+{
+    return m_senderGateways;
+}
+
+NetDeviceContainer
+DumbbellTopology::GetBottleneckDevices() const
+{
+    return m_bottlenecks;
+}
+
+std::map<uint32_t, std::string>
+DumbbellTopology::GetNodeLabels() const
+{
+    std::map<uint32_t, std::string> labels;
+    auto label = [&labels](const NodeContainer& nodes, const std::string& name) {
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            labels[nodes.Get(i)->GetId()] =
+                nodes.GetN() == 1 ? name : name + std::to_string(i);
+        }
+    };
+    label(m_routers, "router");
+    label(m_senders, "sender");
+    label(m_receivers, "receiver");
+    return labels;
+}
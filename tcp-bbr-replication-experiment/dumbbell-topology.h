@@ -0,0 +1,73 @@
+#ifndef DUMBBELL_TOPOLOGY_H
+#define DUMBBELL_TOPOLOGY_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <map>
+#include <string>
+
+// Shape of the dumbbell
+struct DumbbellConfig
+{
+    uint32_t senders = 1;
+    uint32_t receivers = 1;
+    // Bottleneck links in a row (a parking lot when > 1)
+    uint32_t bottleneckHops = 1;
+    std::string accessRate = "10Gbps";
+    std::string bottleneckRate = "1.25Mbps";
+    std::string bottleneckDelay = "4.8ms";
+    // Delay of each sender/receiver access link: a time ("4.8ms") or a random
+    // variable drawn once per link, in milliseconds
+    // ("ns3::UniformRandomVariable[Min=1|Max=20]")
+    std::string senderDelay = "4.8ms";
+    std::string receiverDelay = "4.8ms";
+};
+
+// Senders and receivers connected by a chain of bottleneck links:
+//
+//   sender_i --access-- router_0 ==bottleneck== ... router_h-1 ==bottleneck== receiver side
+//
+// With a single receiver the last bottleneck link ends at the receiver (the
+// original three-node dumbbell for one sender and one hop). Otherwise it ends
+// at one more router that connects the receivers through access links.
+//
+// Routes are installed statically instead of through global routing: every
+// host and router has a default route towards the receivers, and the routers
+// behind the first one a route to the sender network (10.1.0.0/16) pointing
+// back. Receivers are in 10.3.0.0/16 and bottleneck links in 10.2.0.0/16, one
+// /30 per link, so building is linear in the number of nodes.
+class DumbbellTopology
+{
+  public:
+    explicit DumbbellTopology(const DumbbellConfig& config);
+
+    ns3::NodeContainer GetSenders() const;
+    ns3::NodeContainer GetReceivers() const;
+    ns3::NodeContainer GetRouters() const;
+    ns3::Ipv4Address GetReceiverAddress(uint32_t i) const;
+
+    // Router side devices of the sender access links, and the forward
+    // (towards the receivers) device of every bottleneck link
+    ns3::NetDeviceContainer GetSenderGatewayDevices() const;
+    ns3::NetDeviceContainer GetBottleneckDevices() const;
+
+    // Longest round-trip propagation delay between a sender and a receiver
+    ns3::Time GetMaxPropagationRtt() const;
+
+    // Node id -> name, e.g. for EventProfiler::Write
+    std::map<uint32_t, std::string> GetNodeLabels() const;
+
+  private:
+    ns3::NodeContainer m_senders;
+    ns3::NodeContainer m_receivers;
+    ns3::NodeContainer m_routers;
+    ns3::NetDeviceContainer m_senderGateways;
+    ns3::NetDeviceContainer m_bottlenecks;
+    std::vector<ns3::Ipv4Address> m_receiverAddresses;
+    ns3::Time m_maxPropagationRtt;
+};
+
+#endif /* DUMBBELL_TOPOLOGY_H */
@@ -0,0 +1,335 @@
+#include "event-profiler.h"
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <fstream>
+#include <iomanip>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingScheduler);
+
+namespace
+{
+
+// First template argument of a demangled name, i.e. the scheduled function
+// type for events created by MakeEvent<...>()
+std::string
+FirstTemplateArgument(const std::string& name)
+{
+    std::size_t begin = name.find('<');
+    if (begin == std::string::npos)
+    {
+        return name;
+    }
+    int depth = 0;
+    for (std::size_t i = begin + 1; i < name.size(); ++i)
+    {
+        char c = name[i];
+        if (c == '<' || c == '(')
+        {
+            depth++;
+        }
+        else if ((c == '>' || c == ')') && depth > 0)
+        {
+            depth--;
+        }
+        else if ((c == '>' || c == ',') && depth == 0)
+        {
+            return name.substr(begin + 1, i - begin - 1);
+        }
+    }
+    return name;
+}
+
+// Readable name of an event type, e.g. "PointToPointNetDevice::*" for an event
+// created with MakeEvent(&PointToPointNetDevice::TransmitComplete, this)
+std::string
+EventTypeName(const std::type_info* type)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+    std::string name = (status == 0 && demangled != nullptr) ? demangled : type->name();
+    std::free(demangled);
+
+    std::string function = FirstTemplateArgument(name);
+    // Member function: keep the class, which is what identifies the layer
+    std::size_t member = function.find("::*)");
+    if (member != std::string::npos)
+    {
+        std::size_t start = function.rfind('(', member);
+        std::string cls = function.substr(start + 1, member - start - 1);
+        if (cls.rfind("ns3::", 0) == 0)
+        {
+            cls = cls.substr(5);
+        }
+        return cls + "::*";
+    }
+    // Free function: keep the signature
+    return function;
+}
+
+} // namespace
+
+void
+EventProfiler::Start()
+{
+    m_start = Clock::now();
+    m_last = m_start;
+    m_lastType = nullptr;
+}
+
+void
+EventProfiler::Charge(Clock::time_point now)
+{
+    if (m_lastType == nullptr)
+    {
+        return;
+    }
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last).count();
+    Bucket& byType = m_byType[m_lastType];
+    byType.count++;
+    byType.ns += ns;
+    Bucket& byContext = m_byContext[m_lastContext];
+    byContext.count++;
+    byContext.ns += ns;
+}
+
+void
+EventProfiler::EventStarting(const Scheduler::Event& ev)
+{
+    Clock::time_point now = Clock::now();
+    Charge(now);
+    m_last = now;
+    m_events++;
+    if (ev.impl->IsCancelled())
+    {
+        m_cancelled++;
+    }
+    m_lastType = &typeid(*ev.impl);
+    m_lastContext = ev.key.m_context;
+}
+
+void
+EventProfiler::Stop()
+{
+    m_stop = Clock::now();
+    Charge(m_stop);
+    m_lastType = nullptr;
+}
+
+void
+EventProfiler::Write(std::ostream& os,
+                     Time simulated,
+                     const std::map<uint32_t, std::string>& labels) const
+{
+    double wall = std::chrono::duration<double>(m_stop - m_start).count();
+    os << "Events executed: " << m_events << "\n";
+    os << "Cancelled events: " << m_cancelled << "\n";
+    os << "Wall time: " << wall << " s\n";
+    os << "Simulated time: " << simulated.GetSeconds() << " s\n";
+    os << "Events per wall-second: " << (wall > 0 ? m_events / wall : 0) << "\n";
+    os << "Simulated seconds per wall-second: " << (wall > 0 ? simulated.GetSeconds() / wall : 0)
+       << "\n";
+    os << "Peak RSS: " << GetPeakRssKb() << " kB\n";
+
+    auto table = [&os, wall](const std::vector<std::pair<std::string, Bucket>>& rows) {
+        os << std::left << std::setw(48) << "  name" << std::right << std::setw(14) << "events"
+           << std::setw(12) << "wall s" << std::setw(8) << "%" << std::setw(10) << "ns/event"
+           << "\n";
+        for (const auto& row : rows)
+        {
+            double s = row.second.ns / 1e9;
+            os << "  " << std::left << std::setw(46) << row.first << std::right << std::setw(14)
+               << row.second.count << std::setw(12) << std::fixed << std::setprecision(3) << s
+               << std::setw(8) << std::setprecision(1) << (wall > 0 ? 100 * s / wall : 0)
+               << std::setw(10) << std::setprecision(0)
+               << (row.second.count > 0 ? double(row.second.ns) / row.second.count : 0)
+               << std::defaultfloat << std::setprecision(6) << "\n";
+        }
+    };
+    auto byTime = [](const std::pair<std::string, Bucket>& a,
+                     const std::pair<std::string, Bucket>& b) { return a.second.ns > b.second.ns; };
+
+    // Different event types can shorten to the same name
+    std::map<std::string, Bucket> merged;
+    for (const auto& entry : m_byType)
+    {
+        Bucket& bucket = merged[EventTypeName(entry.first)];
+        bucket.count += entry.second.count;
+        bucket.ns += entry.second.ns;
+    }
+    std::vector<std::pair<std::string, Bucket>> rows(merged.begin(), merged.end());
+    std::sort(rows.begin(), rows.end(), byTime);
+    os << "\nBy event type\n";
+    table(rows);
+
+    rows.clear();
+    for (const auto& entry : m_byContext)
+    {
+        std::string name;
+        auto label = labels.find(entry.first);
+        if (label != labels.end())
+        {
+            name = label->second;
+        }
+        else if (entry.first == Simulator::NO_CONTEXT)
+        {
+            name = "(no node)";
+        }
+        else
+        {
+            name = "node " + std::to_string(entry.first);
+        }
+        rows.emplace_back(name, entry.second);
+    }
+    std::sort(rows.begin(), rows.end(), byTime);
+    os << "\nBy node\n";
+    table(rows);
+}
+
+EventProfiler* ProfilingScheduler::s_profiler = nullptr;
+
+TypeId
+ProfilingScheduler::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ProfilingScheduler")
+            .SetParent<Scheduler>()
+            .AddConstructor<ProfilingScheduler>()
+            .AddAttribute("Inner",
+                          "TypeId of the scheduler that actually orders the events",
+                          StringValue("ns3::MapScheduler"),
+                          MakeStringAccessor(&ProfilingScheduler::SetInner,
+                                             &ProfilingScheduler::GetInner),
+                          MakeStringChecker());
+    return tid;
+}
+
+void
+ProfilingScheduler::SetProfiler(EventProfiler* profiler)
+{
+    s_profiler = profiler;
+}
+
+void
+ProfilingScheduler::SetInner(std::string typeId)
+{
+    ObjectFactory factory;
+    factory.SetTypeId(typeId);
+    m_inner = factory.Create<Scheduler>();
+    m_innerType = typeId;
+}
+
+std::string
+ProfilingScheduler::GetInner() const
+{
+    return m_innerType;
+}
+
+void
+ProfilingScheduler::Insert(const Event& ev)
+{
+    m_inner->Insert(ev);
+}
+
+bool
+ProfilingScheduler::IsEmpty() const
+{
+    return m_inner->IsEmpty();
+}
+
+Scheduler::Event
+ProfilingScheduler::PeekNext() const
+{
+    return m_inner->PeekNext();
+}
+
+Scheduler::Event
+ProfilingScheduler::RemoveNext()
+{
+    Event ev = m_inner->RemoveNext();
+    if (s_profiler != nullptr)
+    {
+        s_profiler->EventStarting(ev);
+    }
+    return ev;
+}
+
+void
+ProfilingScheduler::Remove(const Event& ev)
+{
+    m_inner->Remove(ev);
+}
+
+void
+ProfilingScheduler::DoDispose()
+{
+    m_inner = nullptr;
+    Scheduler::DoDispose();
+}
+
+namespace
+{
+
+// Value of the "name: value kB" line of /proc/self/status, 0 if there is none
+uint64_t
+ReadStatusKb(const std::string& name)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, name.size() + 1, name + ":") == 0)
+        {
+            return std::stoull(line.substr(name.size() + 1));
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+bool
+ResetPeakRss()
+{
+    // Linux resets VmHWM, but not ru_maxrss, when 5 is written to clear_refs
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return clearRefs.good() && ReadStatusKb("VmHWM") > 0;
+}
+
+uint64_t
+GetPeakRssKb()
+{
+    uint64_t hwm = ReadStatusKb("VmHWM");
+    if (hwm > 0)
+    {
+        return hwm;
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    // ru_maxrss is in kB on Linux
+    return usage.ru_maxrss;
+}
+
+uint64_t
+GetRssKb()
+{
+    // Second field of statm, in pages
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
@@ -0,0 +1,96 @@
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+// Wall-clock profile of the events executed by the simulator.
+//
+// The ProfilingScheduler reports every event just before it is executed, so
+// the wall time until the next event is charged to it (including the events
+// it schedules). Events are grouped by their type, which identifies the
+// scheduled function or member function (e.g. PointToPointNetDevice::*), and
+// by their context, i.e. the node they run on.
+class EventProfiler
+{
+  public:
+    // Call right before / after Simulator::Run()
+    void Start();
+    void Stop();
+
+    void EventStarting(const ns3::Scheduler::Event& ev);
+
+    // labels names the node ids used as event context
+    void Write(std::ostream& os,
+               ns3::Time simulated,
+               const std::map<uint32_t, std::string>& labels) const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Bucket
+    {
+        uint64_t count{0};
+        int64_t ns{0};
+    };
+
+    void Charge(Clock::time_point now);
+
+    Clock::time_point m_start;
+    Clock::time_point m_stop;
+    Clock::time_point m_last;
+    const std::type_info* m_lastType{nullptr};
+    uint32_t m_lastContext{0};
+    uint64_t m_events{0};
+    uint64_t m_cancelled{0};
+    std::unordered_map<const std::type_info*, Bucket> m_byType;
+    std::map<uint32_t, Bucket> m_byContext;
+};
+
+// Scheduler forwarding to another scheduler (attribute Inner, by default the
+// ns-3 default MapScheduler) and reporting each event to the EventProfiler
+// set with SetProfiler().
+class ProfilingScheduler : public ns3::Scheduler
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    static void SetProfiler(EventProfiler* profiler);
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void SetInner(std::string typeId);
+    std::string GetInner() const;
+
+    ns3::Ptr<ns3::Scheduler> m_inner;
+    std::string m_innerType;
+    static EventProfiler* s_profiler;
+};
+
+// Peak resident set size of this process in kB, since the last ResetPeakRss()
+uint64_t GetPeakRssKb();
+
+// Start measuring the peak resident set size anew, e.g. for the next run of a
+// sweep in the same process. Returns false if the peak cannot be reset (only
+// Linux can), so that GetPeakRssKb() stays the peak of the whole process.
+bool ResetPeakRss();
+
+// Current resident set size of this process in kB
+uint64_t GetRssKb();
+
+#endif /* EVENT_PROFILER_H */
@@ -0,0 +1,323 @@
+#include "fluid-model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <stdexcept>
+
+namespace
+{
+
+// One flow's share of the bottleneck seen by a congestion controller, all in
+// packets and seconds
+struct FlowSample
+{
+    double rtt;       // current RTT
+    double delivered; // delivery rate of this step
+    bool lost;        // the queue dropped packets in this step
+    double queueDelay;
+};
+
+class CubicFlow
+{
+  public:
+    explicit CubicFlow(const FluidConfig& config)
+        : m_cwnd(config.initialCwnd),
+          m_hystartDelay(std::clamp(config.baseRtt / 8, 0.004, 0.016))
+    {
+    }
+
+    double GetRate(double rtt) const
+    {
+        return m_cwnd / rtt;
+    }
+
+    void Update(double t, double dt, const FlowSample& s)
+    {
+        // The sender learns of a loss one RTT later and reduces once per RTT
+        if (s.lost && m_lossDetected < 0 && t >= m_recoveryEnd)
+        {
+            m_lossDetected = t + s.rtt;
+        }
+        if (m_lossDetected >= 0 && t >= m_lossDetected)
+        {
+            m_maxCwnd = m_cwnd < m_lastMaxCwnd ? m_cwnd * (1 + kBeta) / 2 : m_cwnd;
+            m_lastMaxCwnd = m_cwnd;
+            m_cwnd = std::max(m_cwnd * kBeta, 2.0);
+            m_slowStart = false;
+            StartEpoch(t);
+            m_recoveryEnd = t + s.rtt;
+            m_lossDetected = -1;
+            return;
+        }
+        if (t < m_recoveryEnd)
+        {
+            return;
+        }
+        if (m_slowStart)
+        {
+            m_cwnd += m_cwnd / s.rtt * dt;
+            if (m_cwnd >= kHystartLowWindow && s.queueDelay > m_hystartDelay)
+            {
+                m_slowStart = false;
+                m_maxCwnd = m_cwnd;
+                StartEpoch(t);
+            }
+            return;
+        }
+        // Cubic window, or the TCP-friendly one if larger, approached within an RTT
+        double elapsed = t - m_epochStart;
+        double cubic = kC * std::pow(elapsed - m_k, 3) + m_maxCwnd;
+        double friendly = m_maxCwnd * kBeta + 3 * (1 - kBeta) / (1 + kBeta) * elapsed / s.rtt;
+        double target = std::max(cubic, friendly);
+        if (target > m_cwnd)
+        {
+            m_cwnd += (target - m_cwnd) / s.rtt * dt;
+        }
+    }
+
+  private:
+    void StartEpoch(double t)
+    {
+        m_epochStart = t;
+        m_k = std::cbrt(std::max(m_maxCwnd - m_cwnd, 0.0) / kC);
+    }
+
+    static constexpr double kBeta = 0.7;
+    static constexpr double kC = 0.4;
+    static constexpr double kHystartLowWindow = 16;
+
+    double m_cwnd;
+    double m_hystartDelay;
+    bool m_slowStart{true};
+    double m_maxCwnd{0};
+    double m_lastMaxCwnd{0};
+    double m_epochStart{0};
+    double m_k{0};
+    double m_lossDetected{-1};
+    double m_recoveryEnd{0};
+};
+
+class BbrFlow
+{
+  public:
+    explicit BbrFlow(const FluidConfig& config)
+        : m_cwnd(config.initialCwnd),
+          m_btlBw(config.initialCwnd / config.baseRtt),
+          m_minRtt(config.baseRtt)
+    {
+    }
+
+    double GetRate(double rtt) const
+    {
+        return std::min(GetPacingGain() * m_btlBw, m_cwnd / rtt);
+    }
+
+    void Update(double t, double dt, const FlowSample& s, double inflight)
+    {
+        // Bottleneck bandwidth: max of the delivery rate over the last 10
+        // rounds. ProbeRTT rounds are app-limited and leave the filter alone.
+        m_roundMax = std::max(m_roundMax, s.delivered);
+        if (t - m_roundStart >= s.rtt)
+        {
+            if (m_mode != Mode::PROBE_RTT)
+            {
+                m_rounds.push_back(m_roundMax);
+                if (m_rounds.size() > 10)
+                {
+                    m_rounds.pop_front();
+                }
+                m_btlBw = std::max(*std::max_element(m_rounds.begin(), m_rounds.end()), 1e-3);
+            }
+            m_roundMax = 0;
+            m_roundStart = t;
+            if (!m_filledPipe)
+            {
+                if (m_btlBw >= m_fullBw * 1.25)
+                {
+                    m_fullBw = m_btlBw;
+                    m_fullBwRounds = 0;
+                }
+                else if (++m_fullBwRounds >= 3)
+                {
+                    m_filledPipe = true;
+                    m_mode = Mode::DRAIN;
+                }
+            }
+        }
+
+        if (s.rtt <= m_minRtt)
+        {
+            m_minRtt = s.rtt;
+            m_minRttStamp = t;
+        }
+        else if (t - m_minRttStamp > 10 && m_mode != Mode::PROBE_RTT)
+        {
+            m_minRtt = s.rtt;
+            m_minRttStamp = t;
+            m_mode = Mode::PROBE_RTT;
+            m_probeRttEnd = t + 0.2 + s.rtt;
+        }
+
+        double bdp = m_btlBw * m_minRtt;
+        switch (m_mode)
+        {
+        case Mode::STARTUP:
+            break;
+        case Mode::DRAIN:
+            if (inflight <= bdp)
+            {
+                m_mode = Mode::PROBE_BW;
+                m_cycleIndex = 2;
+                m_cycleStart = t;
+            }
+            break;
+        case Mode::PROBE_BW:
+            if (t - m_cycleStart >= m_minRtt)
+            {
+                m_cycleIndex = (m_cycleIndex + 1) % 8;
+                m_cycleStart = t;
+            }
+            break;
+        case Mode::PROBE_RTT:
+            if (t >= m_probeRttEnd)
+            {
+                m_minRttStamp = t;
+                m_mode = m_filledPipe ? Mode::PROBE_BW : Mode::STARTUP;
+                m_cycleStart = t;
+            }
+            break;
+        }
+
+        // cwnd grows with the deliveries up to its target, which it is held
+        // at once the pipe is full
+        double target = std::max(GetCwndGain() * bdp, kMinCwnd);
+        if (m_mode == Mode::PROBE_RTT)
+        {
+            m_cwnd = kMinCwnd;
+        }
+        else if (m_filledPipe)
+        {
+            m_cwnd = target;
+        }
+        else
+        {
+            m_cwnd = std::min(m_cwnd + s.delivered * dt, target);
+        }
+    }
+
+  private:
+    enum class Mode
+    {
+        STARTUP,
+        DRAIN,
+        PROBE_BW,
+        PROBE_RTT,
+    };
+
+    double GetPacingGain() const
+    {
+        static const double cycle[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+        switch (m_mode)
+        {
+        case Mode::STARTUP:
+            return kHighGain;
+        case Mode::DRAIN:
+            return 1 / kHighGain;
+        case Mode::PROBE_BW:
+            return cycle[m_cycleIndex];
+        default:
+            return 1;
+        }
+    }
+
+    double GetCwndGain() const
+    {
+        return m_mode == Mode::PROBE_BW ? 2 : kHighGain;
+    }
+
+    static constexpr double kHighGain = 2.885; // 2 / ln 2
+    static constexpr double kMinCwnd = 4;
+
+    Mode m_mode{Mode::STARTUP};
+    double m_cwnd;
+    double m_btlBw;
+    double m_minRtt;
+    double m_minRttStamp{0};
+    std::deque<double> m_rounds;
+    double m_roundMax{0};
+    double m_roundStart{0};
+    bool m_filledPipe{false};
+    double m_fullBw{0};
+    uint32_t m_fullBwRounds{0};
+    uint32_t m_cycleIndex{0};
+    double m_cycleStart{0};
+    double m_probeRttEnd{0};
+};
+
+} // namespace
+
+FluidResult
+RunFluidModel(const FluidConfig& config)
+{
+    bool bbr = config.congestionControl == "TcpBbr";
+    if (!bbr && config.congestionControl != "TcpCubic")
+    {
+        throw std::invalid_argument("No fluid model of " + config.congestionControl);
+    }
+    if (config.flows == 0 || config.baseRtt <= 0 || config.bottleneckRate <= 0)
+    {
+        throw std::invalid_argument("Fluid model needs flows, a positive RTT and rate");
+    }
+
+    // Packets of packetSize and seconds throughout
+    double capacity = config.bottleneckRate / (8.0 * config.packetSize);
+    double limit = config.queueLimit / config.packetSize;
+    double dt = config.baseRtt / 64;
+    CubicFlow cubic(config);
+    BbrFlow bbrFlow(config);
+
+    FluidResult result;
+    double queue = 0;
+    double served = 0;
+    double area = 0;
+    for (double t = config.start; t < config.stop; t += dt)
+    {
+        double rtt = config.baseRtt + queue / capacity;
+        double rate = bbr ? bbrFlow.GetRate(rtt) : cubic.GetRate(rtt);
+        double arrived = rate * config.flows * dt;
+        double service = std::min(capacity * dt, queue + arrived);
+        double next = queue + arrived - service;
+        double dropped = std::max(next - limit, 0.0);
+        queue = next - dropped;
+
+        result.sentPackets += arrived;
+        result.lostPackets += dropped;
+        result.maxQueue = std::max(result.maxQueue, queue);
+        served += service;
+        area += queue * dt;
+        result.steps++;
+
+        FlowSample sample;
+        sample.rtt = rtt;
+        sample.delivered = service / dt / config.flows;
+        sample.lost = dropped > 0;
+        sample.queueDelay = queue / capacity;
+        if (bbr)
+        {
+            // Own share of the queue plus what is on the links
+            double inflight = queue / config.flows + sample.delivered * config.baseRtt;
+            bbrFlow.Update(t, dt, sample, inflight);
+        }
+        else
+        {
+            cubic.Update(t, dt, sample);
+        }
+    }
+
+    double active = config.stop - config.start;
+    result.goodput = active > 0 ? served * config.segmentSize * 8 / active / 1e6 : 0;
+    result.averageQueue = config.stop > 0 ? area * config.packetSize / config.stop : 0;
+    result.maxQueue *= config.packetSize;
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef FLUID_MODEL_H
+#define FLUID_MODEL_H
+
+#include <cstdint>
+#include <string>
+
+// The dumbbell of tcp-bbr-replication.cc reduced to numbers: the flows share
+// one FIFO of queueLimit bytes in front of the first bottleneck link, and
+// every other delay is folded into baseRtt
+struct FluidConfig
+{
+    double bottleneckRate{1.25e6}; // bit/s
+    double baseRtt{0.0192};        // s, propagation and serialization without queueing
+    double queueLimit{1e5};        // bytes, qdisc and device queue together
+    uint32_t segmentSize{1448};    // payload of a segment
+    uint32_t packetSize{1502};     // bytes of a segment on the bottleneck link
+    uint32_t flows{1};
+    std::string congestionControl{"TcpCubic"}; // TcpCubic or TcpBbr
+    uint32_t initialCwnd{10};                   // segments
+    double start{1};                            // s, when the flows start
+    double stop{60};                            // s
+};
+
+struct FluidResult
+{
+    double goodput{0};      // Mbps of all flows from start to stop
+    double averageQueue{0}; // bytes, time-average from 0 to stop
+    double maxQueue{0};     // bytes
+    double lostPackets{0};  // of packetSize, dropped at the full queue
+    double sentPackets{0};  // of packetSize, offered to the queue
+    uint64_t steps{0};
+};
+
+// Fluid approximation of the flows of config: every flow sends at cwnd / RTT
+// (TcpCubic) or at its pacing rate limited by cwnd / RTT (TcpBbr), the queue
+// integrates the excess over the bottleneck rate and drops what does not fit,
+// and the RTT is baseRtt plus the queueing delay. The flows are identical and
+// start together, so they are integrated as one flow carrying 1 / flows of
+// the bottleneck. The step is baseRtt / 64, so a 60 s run takes milliseconds.
+//
+// TcpCubic follows RFC 8312 with beta 0.7 and C 0.4, fast convergence and the
+// TCP-friendly region, leaves slow start on the first loss or when HyStart
+// would see the queueing delay exceed clamp(baseRtt / 8, 4 ms, 16 ms), and
+// reacts to a loss one RTT after it, at most once per RTT. TcpBbr follows
+// BBRv1 as in ns-3: Startup and Drain with gain 2/ln 2, ProbeBW cycling its
+// pacing gain over eight min RTTs with a cwnd of 2 BDP, a bottleneck
+// bandwidth filter over 10 rounds and ProbeRTT after 10 s without a lower
+// RTT; losses do not change its rate.
+//
+// Throws std::invalid_argument for any other congestion control, or without
+// flows, RTT or rate.
+FluidResult RunFluidModel(const FluidConfig& config);
+
+#endif /* FLUID_MODEL_H */
@@ -0,0 +1,133 @@
+#include "queue-tracker.h"
+
+using namespace ns3;
+
+QueueOccupancyTracker::QueueOccupancyTracker(Ptr<QueueDisc> queue, uint32_t binWidth)
+    : m_binWidth(binWidth > 0 ? binWidth : 1),
+      m_lastChange(Simulator::Now())
+{
+    if (queue->GetMaxSize().GetUnit() == QueueSizeUnit::BYTES)
+    {
+        m_unit = "bytes";
+        m_current = queue->GetNBytes();
+        queue->TraceConnectWithoutContext(
+            "BytesInQueue",
+            MakeCallback(&QueueOccupancyTracker::Update, this));
+    }
+    else
+    {
+        m_unit = "packets";
+        m_binWidth = 1;
+        m_current = queue->GetNPackets();
+        queue->TraceConnectWithoutContext(
+            "PacketsInQueue",
+            MakeCallback(&QueueOccupancyTracker::Update, this));
+    }
+    m_max = m_current;
+}
+
+void
+QueueOccupancyTracker::EnableSampling(TraceWriter* out, Time interval)
+{
+    NS_ABORT_MSG_UNLESS(interval.IsStrictlyPositive(), "Sampling interval must be positive");
+    m_samples = out;
+    m_sampleInterval = interval;
+    m_nextSample = Simulator::Now();
+}
+
+void
+QueueOccupancyTracker::Update(uint32_t oldValue, uint32_t newValue)
+{
+    Time now = Simulator::Now();
+    WriteSamplesUntil(now);
+
+    int64_t dt = (now - m_lastChange).GetNanoSeconds();
+    if (dt > 0)
+    {
+        std::size_t bin = m_current / m_binWidth;
+        if (bin >= m_timeInBin.size())
+        {
+            m_timeInBin.resize(bin + 1, 0);
+        }
+        m_timeInBin[bin] += dt;
+        m_weightedSum += static_cast<long double>(m_current) * dt;
+        m_totalTime += dt;
+    }
+    m_lastChange = now;
+    m_current = newValue;
+    if (newValue > m_max)
+    {
+        m_max = newValue;
+    }
+}
+
+void
+QueueOccupancyTracker::WriteSamplesUntil(Time t)
+{
+    if (m_samples == nullptr)
+    {
+        return;
+    }
+    // The value on the grid points before t is the one held since the last change
+    while (m_nextSample < t)
+    {
+        m_samples->Write(m_nextSample.GetNanoSeconds(), m_current);
+        m_nextSample += m_sampleInterval;
+    }
+}
+
+void
+QueueOccupancyTracker::Finish()
+{
+    Update(m_current, m_current);
+}
+
+double
+QueueOccupancyTracker::GetTimeAverage() const
+{
+    return m_totalTime > 0 ? static_cast<double>(m_weightedSum / m_totalTime) : m_current;
+}
+
+long double
+QueueOccupancyTracker::GetArea() const
+{
+    int64_t sinceChange = (Simulator::Now() - m_lastChange).GetNanoSeconds();
+    return m_weightedSum + static_cast<long double>(m_current) * sinceChange;
+}
+
+uint32_t
+QueueOccupancyTracker::GetMax() const
+{
+    return m_max;
+}
+
+uint32_t
+QueueOccupancyTracker::GetPercentile(double p) const
+{
+    if (m_totalTime == 0)
+    {
+        return m_current;
+    }
+    long double target = m_totalTime * p / 100.0L;
+    int64_t cumulative = 0;
+    for (std::size_t bin = 0; bin < m_timeInBin.size(); ++bin)
+    {
+        cumulative += m_timeInBin[bin];
+        if (cumulative >= target && m_timeInBin[bin] > 0)
+        {
+            return bin * m_binWidth;
+        }
+    }
+    return m_max;
+}
+
+void
+QueueOccupancyTracker::Print(std::ostream& os) const
+{
+    os << "  Unit: " << m_unit << "\n";
+    os << "  Time-average: " << GetTimeAverage() << "\n";
+    os << "  Max: " << GetMax() << "\n";
+    os << "  p50: " << GetPercentile(50) << "\n";
+    os << "  p90: " << GetPercentile(90) << "\n";
+    os << "  p99: " << GetPercentile(99) << "\n";
+}
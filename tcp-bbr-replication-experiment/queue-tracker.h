@@ -0,0 +1,61 @@
+#ifndef QUEUE_TRACKER_H
+#define QUEUE_TRACKER_H
+
+#include "ns3/core-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "../tcp-scenario-common/trace-writer.h"
+
+#include <ostream>
+#include <vector>
+
+// Tracks the occupancy of a queue disc from its PacketsInQueue/BytesInQueue
+// trace source, so work is only done when the queue actually changes.
+//
+// Keeps the exact time-weighted average and maximum, and a time-weighted
+// histogram (bins of binWidth) from which percentiles are taken. Optionally
+// writes "time value" samples on a fixed grid for plotting; the samples are
+// filled in when the queue changes, so no simulator events are needed.
+class QueueOccupancyTracker
+{
+  public:
+    // Values are tracked in the unit of the queue's MaxSize (bytes or packets),
+    // like QueueDisc::GetCurrentSize(). binWidth is the histogram resolution in
+    // bytes; packet counts are always binned exactly.
+    QueueOccupancyTracker(ns3::Ptr<ns3::QueueDisc> queue, uint32_t binWidth);
+
+    // Write one sample every interval to out (queue-size.dat)
+    void EnableSampling(TraceWriter* out, ns3::Time interval);
+
+    // Account for the time from the last change until now and write the
+    // remaining samples. Call once after Simulator::Run().
+    void Finish();
+
+    double GetTimeAverage() const;
+    // Integral of the occupancy over time up to now, in value x nanoseconds
+    long double GetArea() const;
+    uint32_t GetMax() const;
+    // Time-weighted percentile, p in [0, 100]
+    uint32_t GetPercentile(double p) const;
+
+    void Print(std::ostream& os) const;
+
+  private:
+    void Update(uint32_t oldValue, uint32_t newValue);
+    void WriteSamplesUntil(ns3::Time t);
+
+    uint32_t m_binWidth;
+    std::string m_unit;
+    uint32_t m_current{0};
+    uint32_t m_max{0};
+    ns3::Time m_lastChange;
+    long double m_weightedSum{0}; // sum of value x nanoseconds
+    int64_t m_totalTime{0};       // nanoseconds
+    std::vector<int64_t> m_timeInBin;
+
+    TraceWriter* m_samples{nullptr};
+    ns3::Time m_sampleInterval;
+    ns3::Time m_nextSample;
+};
+
+#endif /* QUEUE_TRACKER_H */
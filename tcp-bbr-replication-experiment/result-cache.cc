@@ -0,0 +1,252 @@
+#include "result-cache.h"
+
+#include "ns3/core-module.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+uint64_t
+Fnv1a(const std::string& data)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Path, size and modification time of the executable and of every ns-3
+// library mapped into the process. Rebuilding any of them changes the result.
+const std::string&
+GetBuildIdentity()
+{
+    static std::string identity;
+    if (!identity.empty())
+    {
+        return identity;
+    }
+    std::set<std::string> files;
+    std::error_code ec;
+    fs::path exe = fs::read_symlink("/proc/self/exe", ec);
+    if (!ec)
+    {
+        files.insert(exe.string());
+    }
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line))
+    {
+        std::size_t path = line.find('/');
+        if (path != std::string::npos && line.find("libns3", path) != std::string::npos)
+        {
+            files.insert(line.substr(path));
+        }
+    }
+    std::ostringstream os;
+    for (const std::string& file : files)
+    {
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0)
+        {
+            os << file << " " << st.st_size << " " << st.st_mtim.tv_sec << "."
+               << st.st_mtim.tv_nsec << "\n";
+        }
+    }
+    identity = os.str();
+    return identity;
+}
+
+// Put the directory from in the place of to in one step, replacing an
+// existing to, which is removed afterwards. A reader of to sees the old or
+// the new directory, never none. Throws fs::filesystem_error on failure.
+void
+ReplaceDirectory(const fs::path& from, const fs::path& to)
+{
+    if (std::rename(from.c_str(), to.c_str()) == 0)
+    {
+        return;
+    }
+    if (errno != ENOTEMPTY && errno != EEXIST)
+    {
+        throw fs::filesystem_error("rename",
+                                   from,
+                                   to,
+                                   std::error_code(errno, std::generic_category()));
+    }
+#ifdef RENAME_EXCHANGE
+    // Linux: swap the two, then remove the old one now at from
+    if (renameat2(AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), RENAME_EXCHANGE) == 0)
+    {
+        fs::remove_all(from);
+        return;
+    }
+#endif
+    // Elsewhere the old directory is moved aside first, leaving a short gap
+    fs::path aside = from.string() + ".old";
+    fs::rename(to, aside);
+    fs::rename(from, to);
+    fs::remove_all(aside);
+}
+
+} // namespace
+
+ResultCache::ResultCache(const std::string& resultsDir)
+    : m_cacheDir(resultsDir + ".cache/")
+{
+}
+
+std::string
+ResultCache::ComputeKey(const std::string& config)
+{
+    std::ostringstream os;
+    os << config << "rngSeed " << RngSeedManager::GetSeed() << "\nrngRun "
+       << RngSeedManager::GetRun() << "\n"
+       << GetBuildIdentity();
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(Fnv1a(os.str())));
+    return key;
+}
+
+std::string
+ResultCache::ComputeFileHash(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        return "missing";
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    char hash[17];
+    std::snprintf(hash,
+                  sizeof(hash),
+                  "%016llx",
+                  static_cast<unsigned long long>(Fnv1a(contents.str())));
+    return hash;
+}
+
+std::string
+ResultCache::GetEntryDir(const std::string& key) const
+{
+    return m_cacheDir + key + "/";
+}
+
+bool
+ResultCache::Contains(const std::string& key) const
+{
+    return fs::is_directory(m_cacheDir + key);
+}
+
+std::string
+ResultCache::BeginEntry(const std::string& key) const
+{
+    fs::create_directories(m_cacheDir);
+    // Temporary directories are named <key>.tmp.<pid>; those of processes
+    // that are gone were left by interrupted runs
+    std::string prefix = key + ".tmp.";
+    for (const fs::directory_entry& entry : fs::directory_iterator(m_cacheDir))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) == 0)
+        {
+            pid_t pid = std::stoi(name.substr(prefix.size()));
+            if (pid == getpid() || (kill(pid, 0) != 0 && errno == ESRCH))
+            {
+                fs::remove_all(entry.path());
+            }
+        }
+    }
+    std::string tmpDir = m_cacheDir + prefix + std::to_string(getpid()) + "/";
+    fs::create_directories(tmpDir);
+    return tmpDir;
+}
+
+void
+ResultCache::CommitEntry(const std::string& key,
+                         const std::string& tmpDir,
+                         const std::string& config) const
+{
+    std::ofstream(tmpDir + "cache-key.txt") << config;
+    // An existing entry is only there after a forced re-run (e.g. a
+    // benchmark) or when another process committed the same key meanwhile;
+    // either way the entries are interchangeable, so the newest one stays
+    fs::path tmp = fs::path(tmpDir).parent_path();
+    try
+    {
+        ReplaceDirectory(tmp, m_cacheDir + key);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        // Lost a race with another writer of key, whose entry is complete
+        NS_ABORT_MSG_UNLESS(Contains(key),
+                            "Cannot commit cache entry " << key << ": " << e.what());
+        std::error_code ec;
+        fs::remove_all(tmp, ec);
+    }
+}
+
+void
+ResultCache::Link(const std::string& key, const std::string& linkPath) const
+{
+    fs::path link = fs::path(linkPath).lexically_normal();
+    if (!link.has_filename())
+    {
+        link = link.parent_path();
+    }
+    fs::create_directories(link.parent_path());
+    // Result directories of older versions are plain directories
+    if (fs::is_directory(fs::symlink_status(link)))
+    {
+        fs::remove_all(link);
+    }
+    fs::path target = fs::relative(fs::absolute(m_cacheDir + key),
+                                   fs::absolute(link.parent_path()));
+    fs::path tmpLink = link.string() + ".tmp." + std::to_string(getpid());
+    fs::remove(tmpLink);
+    fs::create_symlink(target, tmpLink);
+    fs::rename(tmpLink, link);
+}
+
+void
+ResultCache::Unlink(const std::string& linkPath) const
+{
+    fs::path link = fs::path(linkPath).lexically_normal();
+    if (!link.has_filename())
+    {
+        link = link.parent_path();
+    }
+    std::error_code ec;
+    if (fs::is_symlink(fs::symlink_status(link, ec)))
+    {
+        fs::remove(link, ec);
+    }
+}
+
+void
+ResultCache::KeepPartial(const std::string& tmpDir, const std::string& partialDir) const
+{
+    fs::path target = fs::path(partialDir).lexically_normal();
+    if (!target.has_filename())
+    {
+        target = target.parent_path();
+    }
+    fs::create_directories(target.parent_path());
+    ReplaceDirectory(fs::path(tmpDir).parent_path(), target);
+}
@@ -0,0 +1,51 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <string>
+
+// Content-addressed store of simulation results.
+//
+// Every run is keyed by a hash over the description of its effective
+// configuration, the RNG seed and run number and the identity of the build
+// (the simulator binary and the ns-3 libraries it has loaded). The results of
+// a run are written to a temporary directory and renamed into
+// <resultsDir>/.cache/<key>/ only once they are complete, so an interrupted
+// run never leaves a partial entry behind. The usual per-run result directory
+// is a symbolic link to the entry.
+class ResultCache
+{
+  public:
+    explicit ResultCache(const std::string& resultsDir);
+
+    // Key of a run, config is a canonical "name value" description of every
+    // parameter that affects the results
+    static std::string ComputeKey(const std::string& config);
+    // Hash of the contents of an input file of a run, for its config;
+    // "missing" if it cannot be read
+    static std::string ComputeFileHash(const std::string& path);
+
+    std::string GetEntryDir(const std::string& key) const;
+    bool Contains(const std::string& key) const;
+
+    // Create an empty temporary directory to write the results of key to.
+    // Leftovers of runs of the same key that were interrupted are removed.
+    std::string BeginEntry(const std::string& key) const;
+    // Publish the results in tmpDir as the entry of key, replacing an older
+    // entry in one rename. config is stored next to them as cache-key.txt.
+    // Concurrent writers of the same key are safe; one entry wins.
+    void CommitEntry(const std::string& key,
+                     const std::string& tmpDir,
+                     const std::string& config) const;
+    // Atomically point linkPath (a result directory) at the entry of key
+    void Link(const std::string& key, const std::string& linkPath) const;
+    // Remove linkPath if it is a link to an entry; the entry itself stays
+    void Unlink(const std::string& linkPath) const;
+    // Move the results in tmpDir of a run that was stopped early to
+    // partialDir instead of publishing them, replacing older ones there
+    void KeepPartial(const std::string& tmpDir, const std::string& partialDir) const;
+
+  private:
+    std::string m_cacheDir;
+};
+
+#endif /* RESULT_CACHE_H */
@@ -0,0 +1,186 @@
+#include "run-watchdog.h"
+
+#include "event-profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+namespace
+{
+
+// Wall-clock seconds between two checks of the run
+const double CHECK_PERIOD = 0.1;
+
+} // namespace
+
+RunWatchdog::RunWatchdog(const std::string& statusFile,
+                         double heartbeat,
+                         double maxWallSeconds,
+                         uint64_t maxRssKb)
+    : m_statusFile(statusFile),
+      m_heartbeat(heartbeat),
+      m_maxWallSeconds(maxWallSeconds),
+      m_maxRssKb(maxRssKb),
+      m_wallStart(std::chrono::steady_clock::now())
+{
+}
+
+void
+RunWatchdog::Start(Time stopTime)
+{
+    m_stopTime = stopTime;
+    if (m_heartbeat <= 0 && m_maxWallSeconds <= 0 && m_maxRssKb == 0)
+    {
+        return;
+    }
+    m_lastWall = m_runWall = m_lastHeartbeat = GetWallSeconds();
+    m_lastSim = m_runSim = Simulator::Now();
+    m_interval = MilliSeconds(1);
+    WriteStatus("running");
+    Simulator::Schedule(m_interval, &RunWatchdog::Check, this);
+}
+
+bool
+RunWatchdog::HasTripped() const
+{
+    return !m_reason.empty();
+}
+
+uint64_t
+RunWatchdog::GetCheckEvents() const
+{
+    return m_checks;
+}
+
+void
+RunWatchdog::End()
+{
+    m_ended = true;
+    m_endTime = Simulator::Now();
+    m_endEvents = Simulator::GetEventCount();
+}
+
+void
+RunWatchdog::Finish(const std::string& resultDir)
+{
+    WriteStatus(HasTripped() ? "aborted" : "finished", resultDir);
+}
+
+void
+RunWatchdog::Print(std::ostream& os) const
+{
+    if (HasTripped())
+    {
+        os << "Watchdog: stopped at " << m_trippedAt.GetSeconds() << " s of "
+           << m_stopTime.GetSeconds() << " s, " << m_reason << "\n";
+    }
+}
+
+void
+RunWatchdog::Check()
+{
+    m_checks++;
+    double wall = GetWallSeconds();
+    Time now = Simulator::Now();
+    uint64_t rssKb = GetRssKb();
+    if (m_maxWallSeconds > 0 && wall > m_maxWallSeconds)
+    {
+        m_reason = "wall-clock limit of " + std::to_string(m_maxWallSeconds) + " s exceeded";
+    }
+    else if (m_maxRssKb > 0 && rssKb > m_maxRssKb)
+    {
+        m_reason = "memory limit of " + std::to_string(m_maxRssKb) + " kB exceeded (" +
+                   std::to_string(rssKb) + " kB)";
+    }
+    if (HasTripped())
+    {
+        m_trippedAt = now;
+        std::cout << "Watchdog: stopping at " << now.GetSeconds() << " s, " << m_reason
+                  << std::endl;
+        WriteStatus("stopping");
+        Simulator::Stop();
+        return;
+    }
+
+    if (m_heartbeat > 0 && wall - m_lastHeartbeat >= m_heartbeat)
+    {
+        WriteStatus("running");
+        m_lastHeartbeat = wall;
+    }
+
+    // Next check after about CHECK_PERIOD at the speed of the last interval
+    double elapsed = wall - m_lastWall;
+    if (elapsed > 0)
+    {
+        double speed = (now - m_lastSim).GetSeconds() / elapsed;
+        m_interval = Seconds(std::clamp(speed * CHECK_PERIOD, 1e-6, 1.0));
+    }
+    else
+    {
+        m_interval = std::min(m_interval * int64_t(2), Seconds(1));
+    }
+    m_lastWall = wall;
+    m_lastSim = now;
+    Simulator::Schedule(m_interval, &RunWatchdog::Check, this);
+}
+
+void
+RunWatchdog::WriteStatus(const std::string& state, const std::string& resultDir)
+{
+    if (m_heartbeat <= 0)
+    {
+        return;
+    }
+    double wall = GetWallSeconds();
+    Time now = GetSimulatedTime();
+    // Speed and ETA over the event loop so far
+    double runWall = wall - m_runWall;
+    double speed = runWall > 0 ? (now - m_runSim).GetSeconds() / runWall : 0;
+    double eta = speed > 0 ? std::max((m_stopTime - now).GetSeconds(), 0.0) / speed : -1;
+
+    // Readers never see a half-written file
+    std::string tmpFile = m_statusFile + ".tmp";
+    {
+        std::ofstream out(tmpFile);
+        out << "state " << state << "\n";
+        out << "simulatedSeconds " << now.GetSeconds() << "\n";
+        out << "stopSeconds " << m_stopTime.GetSeconds() << "\n";
+        out << "wallSeconds " << wall << "\n";
+        out << "simPerWall " << speed << "\n";
+        out << "events " << GetEvents() << "\n";
+        out << "etaSeconds " << (state == "running" ? eta : 0) << "\n";
+        out << "rssKb " << GetRssKb() << "\n";
+        out << "peakRssKb " << GetPeakRssKb() << "\n";
+        if (HasTripped())
+        {
+            out << "reason " << m_reason << "\n";
+        }
+        if (!resultDir.empty())
+        {
+            out << "resultDir " << resultDir << "\n";
+        }
+    }
+    std::rename(tmpFile.c_str(), m_statusFile.c_str());
+}
+
+double
+RunWatchdog::GetWallSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_wallStart).count();
+}
+
+Time
+RunWatchdog::GetSimulatedTime() const
+{
+    return m_ended ? m_endTime : Simulator::Now();
+}
+
+uint64_t
+RunWatchdog::GetEvents() const
+{
+    return (m_ended ? m_endEvents : Simulator::GetEventCount()) - m_checks;
+}
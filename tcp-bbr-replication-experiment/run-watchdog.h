@@ -0,0 +1,84 @@
+#ifndef RUN_WATCHDOG_H
+#define RUN_WATCHDOG_H
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Heartbeat and watchdog of one simulation run.
+//
+// Every heartbeat seconds of wall-clock time the progress of the run is
+// written to statusFile, replaced atomically, as "name value" lines: state,
+// simulated and wall time, simulation speed (simulated seconds per wall
+// second), events executed, ETA to stopTime and the current resident set.
+// A heartbeat of 0 writes no status file.
+//
+// The watchdog stops the simulation with Simulator::Stop() once the run has
+// taken more than maxWallSeconds since the watchdog was created, or the
+// resident set of the process exceeds maxRssKb (0 = no limit). The results
+// of the simulated time so far are then written as usual, but are partial.
+//
+// Progress is checked by a simulator event, whose interval in simulated time
+// follows the speed of the run so that it fires about every 100 ms of wall
+// time, however fast or slow the simulation is. How many of these events run
+// therefore depends on the machine; GetCheckEvents() tells how many to take
+// off Simulator::GetEventCount() for the events of the scenario itself.
+class RunWatchdog
+{
+  public:
+    RunWatchdog(const std::string& statusFile,
+                double heartbeat,
+                double maxWallSeconds,
+                uint64_t maxRssKb);
+
+    // Schedule the first check, before Simulator::Run()
+    void Start(ns3::Time stopTime);
+
+    // The simulation was stopped by the watchdog
+    bool HasTripped() const;
+
+    // Number of check events executed so far
+    uint64_t GetCheckEvents() const;
+
+    // After Simulator::Run(), before Simulator::Destroy() resets the clock
+    void End();
+
+    // Last status, once the results are in resultDir
+    void Finish(const std::string& resultDir);
+
+    // Line for goodput_retransmission_results.txt if the watchdog tripped
+    void Print(std::ostream& os) const;
+
+  private:
+    void Check();
+    void WriteStatus(const std::string& state, const std::string& resultDir = "");
+    double GetWallSeconds() const;
+    ns3::Time GetSimulatedTime() const;
+    uint64_t GetEvents() const;
+
+    std::string m_statusFile;
+    double m_heartbeat;
+    double m_maxWallSeconds;
+    uint64_t m_maxRssKb;
+    std::chrono::steady_clock::time_point m_wallStart;
+
+    ns3::Time m_stopTime;
+    ns3::Time m_interval;
+    // Progress at the last check and the start of the event loop
+    double m_lastWall{0};
+    ns3::Time m_lastSim;
+    double m_runWall{0};
+    ns3::Time m_runSim;
+    double m_lastHeartbeat{0};
+    std::string m_reason; // why the watchdog tripped, empty if it did not
+    ns3::Time m_trippedAt;
+    uint64_t m_checks{0};
+    bool m_ended{false};
+    ns3::Time m_endTime;
+    uint64_t m_endEvents{0};
+};
+
+#endif /* RUN_WATCHDOG_H */
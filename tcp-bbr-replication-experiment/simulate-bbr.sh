@@ -5,31 +5,16 @@ ROOT_DIR=`pwd`
 CSV_FILE="${ROOT_DIR}/parameters.csv"
 PATH=$PATH:"/home/ubuntu/source/ns-3.42/"
 OUTPUT_DIR="~/simulation_data/"
+# Worker processes, 0 = one per core
+WORKERS=0
 
 #mkdir -p tcp-bbr-cubic-results/throughput
 
-# Read the CSV file line by line
-while IFS=',' read -r qdiscSize bottleneck_bandwidth delay tcpTypeId trial; do
-	# Skip the header line
-	if [[ $qdiscSize == "qdiscSize" ]]; then
-		echo "Skipping header line"
-		continue
-	fi
+# Run every row of the CSV file from a single simulator process, spread over
+# WORKERS forked worker processes.
+# Rows whose results are already in the cache (same parameters, RNG run and
+# build) are skipped, so re-running the grid only simulates new rows.
+COMMAND="ns3 run \"tcp-bbr-replication.cc --sweep=${CSV_FILE} --workers=${WORKERS} --dir=${OUTPUT_DIR}\""
 
-	# Construct the output file name using the parameters
-	OUTPUT_FILE="${OUTPUT_DIR}${qdiscSize}_${bottleneck_bandwidth}_${delay}_${tcpTypeId}/goodput_retransmission_results.txt"
-
-	echo "Output file: $OUTPUT_FILE"
-	# Check if the output file already exists
-	if [ -f "$OUTPUT_FILE" ]; then
-		echo "Output file $OUTPUT_FILE already exists. Skipping..."
-		continue
-	fi
-
-	# Run the simulation
-	COMMAND="ns3 run \"tcp-bbr-replication.cc --qdiscSize=$qdiscSize --bottleneck_bandwidth=$bottleneck_bandwidth --delay=${delay} --tcpTypeId=ns3::$tcpTypeId --dir=${OUTPUT_DIR}\""
-
-	echo "Running: $COMMAND"
-	eval $COMMAND
-
-done <"$CSV_FILE"
+echo "Running: $COMMAND"
+eval $COMMAND
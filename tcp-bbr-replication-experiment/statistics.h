@@ -0,0 +1,60 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+
+// Two-sided 97.5% quantile of Student's t distribution
+inline double
+StudentT975(uint32_t df)
+{
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                   2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                   2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                   2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0)
+    {
+        return INFINITY;
+    }
+    return df <= 30 ? table[df - 1] : 1.96;
+}
+
+// Sample mean with the half-width of its 95% confidence interval. The
+// half-width is 0 for a single sample.
+struct ConfidenceInterval
+{
+    double mean{0};
+    double halfWidth{0};
+    uint32_t samples{0};
+};
+
+template <class Iterator>
+ConfidenceInterval
+EstimateMean(Iterator first, Iterator last)
+{
+    ConfidenceInterval ci;
+    ci.samples = std::distance(first, last);
+    if (ci.samples == 0)
+    {
+        return ci;
+    }
+    for (Iterator i = first; i != last; ++i)
+    {
+        ci.mean += *i;
+    }
+    ci.mean /= ci.samples;
+    if (ci.samples > 1)
+    {
+        double var = 0;
+        for (Iterator i = first; i != last; ++i)
+        {
+            var += (*i - ci.mean) * (*i - ci.mean);
+        }
+        var /= ci.samples - 1;
+        ci.halfWidth = StudentT975(ci.samples - 1) * std::sqrt(var / ci.samples);
+    }
+    return ci;
+}
+
+#endif /* STATISTICS_H */
@@ -0,0 +1,214 @@
+#include "sweep-scheduler.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+// CPUs this process may run on, as limited by its affinity mask (e.g. a
+// cgroup cpuset of a container or a Slurm allocation)
+std::vector<uint32_t>
+GetAllowedCpus()
+{
+    std::vector<uint32_t> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < std::max(online, 1L); ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Restrict the calling process to a single core
+void
+PinToCore(uint32_t core)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    {
+        std::cerr << "Could not pin worker to core " << core << ": " << std::strerror(errno)
+                  << std::endl;
+    }
+#endif
+}
+
+// Send stdout and stderr of the calling process to a file
+void
+RedirectOutput(const std::string& file)
+{
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Could not open " << file << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+}
+
+} // namespace
+
+uint32_t
+GetAvailableCores()
+{
+    return GetAllowedCpus().size();
+}
+
+uint32_t
+RunSweepInParallel(std::vector<SweepJob> jobs,
+                   const std::function<int(std::size_t)>& run,
+                   uint32_t workers,
+                   uint32_t maxRetries,
+                   const std::string& logDir)
+{
+    std::vector<uint32_t> cpus = GetAllowedCpus();
+    if (workers == 0)
+    {
+        workers = cpus.size();
+    }
+
+    // Longest jobs first, so that the short ones fill up the tail of the sweep
+    std::stable_sort(jobs.begin(), jobs.end(), [](const SweepJob& a, const SweepJob& b) {
+        return a.cost > b.cost;
+    });
+
+    std::deque<std::size_t> pending;
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        pending.push_back(i);
+    }
+    std::vector<uint32_t> attempts(jobs.size(), 0);
+    std::vector<uint32_t> freeSlots;
+    for (uint32_t slot = workers; slot > 0; --slot)
+    {
+        freeSlots.push_back(slot - 1);
+    }
+    // pid -> (job, slot)
+    std::map<pid_t, std::pair<std::size_t, uint32_t>> running;
+
+    SystemPath::MakeDirectories(logDir);
+
+    uint32_t done = 0;
+    uint32_t failed = 0;
+    while (!pending.empty() || !running.empty())
+    {
+        while (!pending.empty() && !freeSlots.empty())
+        {
+            std::size_t job = pending.front();
+            pending.pop_front();
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            attempts[job]++;
+
+            // Anything still buffered would otherwise be written twice
+            std::cout.flush();
+            std::clog.flush();
+            std::fflush(nullptr);
+
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed: " << std::strerror(errno));
+            if (pid == 0)
+            {
+                PinToCore(cpus[slot % cpus.size()]);
+                RedirectOutput(logDir + jobs[job].name + ".log");
+                int status = run(jobs[job].row);
+                std::cout.flush();
+                std::clog.flush();
+                std::fflush(nullptr);
+                _exit(status);
+            }
+            running[pid] = std::make_pair(job, slot);
+            std::cout << "[worker " << slot << "] " << jobs[job].name << " started (attempt "
+                      << attempts[job] << ")" << std::endl;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            NS_ABORT_MSG_IF(errno != EINTR, "waitpid() failed: " << std::strerror(errno));
+            continue;
+        }
+        auto it = running.find(pid);
+        if (it == running.end())
+        {
+            continue;
+        }
+        std::size_t job = it->second.first;
+        uint32_t slot = it->second.second;
+        running.erase(it);
+        freeSlots.push_back(slot);
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        {
+            done++;
+            std::cout << "[worker " << slot << "] " << jobs[job].name << " finished (" << done
+                      << "/" << jobs.size() << ")" << std::endl;
+            continue;
+        }
+
+        std::cout << "[worker " << slot << "] " << jobs[job].name << " ";
+        if (WIFEXITED(status) && WEXITSTATUS(status) == SWEEP_JOB_ABORTED)
+        {
+            std::cout << "stopped by its watchdog, not retried (see " << logDir
+                      << jobs[job].name << ".log)" << std::endl;
+            failed++;
+            continue;
+        }
+        if (WIFSIGNALED(status))
+        {
+            std::cout << "killed by signal " << WTERMSIG(status);
+        }
+        else
+        {
+            std::cout << "exited with status " << WEXITSTATUS(status);
+        }
+        if (attempts[job] <= maxRetries)
+        {
+            std::cout << ", retrying" << std::endl;
+            pending.push_front(job);
+        }
+        else
+        {
+            std::cout << ", giving up (see " << logDir << jobs[job].name << ".log)" << std::endl;
+            failed++;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,44 @@
+#ifndef SWEEP_SCHEDULER_H
+#define SWEEP_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Exit status of a job that was stopped by its watchdog (see run-watchdog.h)
+const int SWEEP_JOB_ABORTED = 3;
+
+// One independent unit of work of a sweep (usually one row of parameters.csv)
+struct SweepJob
+{
+    std::size_t row;  // index handed back to the run callback
+    double cost;      // estimated cost; the most expensive jobs are dispatched first
+    std::string name; // used in progress messages and as the worker log file name
+};
+
+// Number of CPUs this process may run on
+uint32_t GetAvailableCores();
+
+// Run the jobs on a local pool of worker processes, one per core slot.
+//
+// The calling process has already loaded and initialized ns-3, so each job is
+// forked from it and starts from the same clean state without paying the start
+// up cost again. Idle slots take the next job from a shared queue ordered by
+// cost, workers are pinned to their core, and a job whose worker crashes or is
+// killed is put back on the queue up to maxRetries times. run returns the exit
+// status of the job; one that returns SWEEP_JOB_ABORTED is not retried, as it
+// would only be stopped again. The output of every job goes to
+// logDir/<name>.log.
+//
+// Workers are pinned to the CPUs of the affinity mask of the process, so a
+// container or batch allocation limited to some CPUs is not oversubscribed.
+// workers == 0 uses one worker per allowed CPU. Returns the number of jobs
+// that still failed after all retries.
+uint32_t RunSweepInParallel(std::vector<SweepJob> jobs,
+                            const std::function<int(std::size_t)>& run,
+                            uint32_t workers,
+                            uint32_t maxRetries,
+                            const std::string& logDir);
+
+#endif /* SWEEP_SCHEDULER_H */
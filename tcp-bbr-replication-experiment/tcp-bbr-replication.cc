@@ -12,11 +12,38 @@
 #include "ns3/flow-monitor-module.h" 
 #include "ns3/trace-helper.h"
 
-
-// #include <fstream>
+#include "../tcp-scenario-common/async-trace-writer.h"
+#include "../tcp-scenario-common/bucket-scheduler.h"
+#include "../tcp-scenario-common/endpoint-accounting.h"
+#include "../tcp-scenario-common/goodput-sampler.h"
+#include "../tcp-scenario-common/scenario-apps.h"
+#include "../tcp-scenario-common/short-flow-workload.h"
+#include "../tcp-scenario-common/socket-buffer-tracker.h"
+#include "../tcp-scenario-common/trace-policies.h"
+#include "adaptive-sweep.h"
+#include "benchmark.h"
+#include "convergence-controller.h"
+#include "dumbbell-topology.h"
+#include "event-profiler.h"
+#include "fluid-model.h"
+#include "queue-tracker.h"
+#include "result-cache.h"
+#include "run-watchdog.h"
+#include "statistics.h"
+#include "sweep-scheduler.h"
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
-#include <sys/stat.h>
+#include <vector>
 
 using namespace ns3;
 // std::string dir = "results/";
@@ -24,27 +51,9 @@ Time stopTime = Seconds(60);
 uint32_t segmentSize = 1448;
 
 // std::ofstream fPlotSsthresh;
-std::ofstream fPlotQueue;
 // std::ofstream fPlotCwnd;
 
-// Function to check queue length of Router 1
-void
-CheckQueueSize(Ptr<QueueDisc> queue)
-{
-    uint32_t qSize = queue->GetCurrentSize().GetValue();
-
-    // Check queue size every 1/100 of a second
-    Simulator::Schedule(Seconds(0.001), &CheckQueueSize, queue);
-    fPlotQueue << Simulator::Now().GetSeconds() << " " << qSize << std::endl;
-}
-
 // Function to trace change in cwnd at n0
-// Function to calculate drops in a particular Queue
-static void
-DropAtQueue(Ptr<OutputStreamWrapper> stream, Ptr<const QueueDiscItem> item)
-{
-    *stream->GetStream() << Simulator::Now().GetSeconds() << " 1" << std::endl;
-}
 // static void
 // CwndChange(uint16_t port, uint32_t oldCwnd, uint32_t newCwnd)
 // {
@@ -79,108 +88,424 @@ DropAtQueue(Ptr<OutputStreamWrapper> stream, Ptr<const QueueDiscItem> item)
 //                                   );
 // }
 
-//Sender side
-// Function to install BulkSend application
-void InstallBulkSend(Ptr<Node> node, Ipv4Address address, uint16_t port,
-                     std::string socketFactory,
-                     uint16_t num_flows = 1)
+// Parameters of a single simulation run. Every column of parameters.csv maps
+// onto one of these fields. Fields that change the results must also be part
+// of DescribeParameters(), which keys the result cache.
+struct SimulationParameters
+{
+    std::string socketFactory = "ns3::TcpSocketFactory";
+    std::string tcpTypeId = "ns3::TcpCubic";
+    std::string qdiscTypeId = "ns3::FifoQueueDisc";
+    bool isSack = true;
+    uint32_t delAckCount = 1;
+    uint32_t segmentSize = 1448;
+    Time stopTime = Seconds(60);
+    std::string qdiscSize = "0.1MB";
+    std::string delay = "4.8ms";
+    std::string bottleneck_bandwidth = "1.25Mbps";
+    std::string dir = "tcp-bbr-cubic-results/";
+    // Trial n runs with RNG run number n (offset by --RngRun)
+    uint32_t trial = 1;
+    Time queueSampleInterval = MilliSeconds(1);
+    std::string traceFormat = "text";
+    bool asyncTraces = true;
+    bool profile = false;
+    // Early termination once the goodput has converged; 0 runs until stopTime
+    double convergenceTolerance = 0;
+    double convergenceQueueTolerance = 0;
+    Time convergenceWindow = Seconds(1);
+    uint32_t convergenceBatches = 10;
+    Time convergenceMinTime = Seconds(10);
+    // Concurrent BulkSend flows and the time between their starts
+    uint16_t numFlows = 1;
+    Time flowStagger = Seconds(0.1);
+    // Random extra delay of each flow start, so that trials differ
+    Time startJitter = Seconds(0);
+    // Per-flow cwnd/ssthresh traces, sampled at most once per interval
+    bool traceCwnd = false;
+    Time cwndSampleInterval = MilliSeconds(10);
+    // TcpBbr state machine, BtlBw, min RTT and pacing rate traces (implies traceCwnd)
+    bool traceBbr = false;
+    // Dumbbell shape; empty access delays use delay
+    uint32_t senders = 1;
+    uint32_t receivers = 1;
+    uint32_t bottleneckHops = 1;
+    std::string senderDelay = "";
+    std::string receiverDelay = "";
+    // Per-flow goodput and retransmissions from FlowMonitor on every node
+    // ("flowmonitor"), from the sender sockets and sinks only ("endpoint"), or
+    // both, with the endpoint numbers in endpoint_results.txt
+    std::string flowAccounting = "flowmonitor";
+    // Bins of the goodput time series and the start of the steady part
+    // measured from the start of the sinks
+    Time goodputBin = MilliSeconds(100);
+    Time warmup = Seconds(5);
+    // Bin width of the FlowMonitor delay and jitter histograms
+    Time histogramBinWidth = MilliSeconds(1);
+    // pcap of every point-to-point device in pcap/, and how it is snapped,
+    // sampled, rotated and compressed
+    bool pcap = false;
+    PcapCaptureConfig pcapCapture;
+    // Event scheduler: map, heap, list, calendar, priority or bucket. All of
+    // them give the same results, so it is not part of DescribeParameters().
+    std::string scheduler = "map";
+    // Socket buffers of this many bandwidth-delay products of the longest
+    // path; 0 gives every socket 1 GB. Their high-water marks are reported
+    // with bufferBdp > 0 or reportBuffers.
+    double bufferBdp = 0;
+    bool reportBuffers = false;
+    // Segments of segmentSize carried by one TCP packet (GSO-style super-
+    // segments): cuts the packets, and so the events, by this factor at the
+    // cost of coarser cwnd steps and losses
+    uint32_t aggregation = 1;
+    // Short flows on top of the long ones, at this fraction of the bottleneck
+    // rate (0 = none), with sizes from the "bytes probability" lines of
+    // flowSizeCdf (empty = the web search distribution)
+    double shortFlowLoad = 0;
+    std::string flowSizeCdf = "";
+    // Persistent connections of every sender that carry the short flows, and
+    // whether every flow starts from the initial window again
+    uint32_t shortFlowConnections = 8;
+    bool shortFlowSlowStart = true;
+    // Reuse the results of an identical earlier run
+    bool useCache = true;
+    // Wall-clock seconds between two status updates in status/ (0 = none),
+    // and the wall-clock seconds and resident MB after which the run is
+    // stopped with partial results (0 = no limit). A run that completes has
+    // the same results either way, so they are not part of DescribeParameters().
+    double heartbeat = 10;
+    double maxWallTime = 0;
+    uint64_t maxRss = 0;
+};
+
+// Canonical description of everything in params that affects the results of a
+// run, one "name value" per line
+std::string
+DescribeParameters(const SimulationParameters& params)
 {
-    for (uint16_t i = 0; i < num_flows; ++i)
+    std::ostringstream os;
+    os << "socketFactory " << params.socketFactory << "\n"
+       << "tcpTypeId " << params.tcpTypeId << "\n"
+       << "qdiscTypeId " << params.qdiscTypeId << "\n"
+       << "isSack " << params.isSack << "\n"
+       << "delAckCount " << params.delAckCount << "\n"
+       << "segmentSize " << params.segmentSize << "\n"
+       << "stopTime " << params.stopTime.GetTimeStep() << "\n"
+       << "qdiscSize " << params.qdiscSize << "\n"
+       << "delay " << params.delay << "\n"
+       << "bottleneck_bandwidth " << params.bottleneck_bandwidth << "\n"
+       << "trial " << params.trial << "\n"
+       << "queueSampleInterval " << params.queueSampleInterval.GetTimeStep() << "\n"
+       << "traceFormat " << params.traceFormat << "\n"
+       << "profile " << params.profile << "\n"
+       << "convergenceTolerance " << params.convergenceTolerance << "\n"
+       << "convergenceQueueTolerance " << params.convergenceQueueTolerance << "\n"
+       << "convergenceWindow " << params.convergenceWindow.GetTimeStep() << "\n"
+       << "convergenceBatches " << params.convergenceBatches << "\n"
+       << "convergenceMinTime " << params.convergenceMinTime.GetTimeStep() << "\n"
+       << "numFlows " << params.numFlows << "\n"
+       << "flowStagger " << params.flowStagger.GetTimeStep() << "\n"
+       << "startJitter " << params.startJitter.GetTimeStep() << "\n"
+       << "traceCwnd " << params.traceCwnd << "\n"
+       << "cwndSampleInterval " << params.cwndSampleInterval.GetTimeStep() << "\n"
+       << "traceBbr " << params.traceBbr << "\n"
+       << "senders " << params.senders << "\n"
+       << "receivers " << params.receivers << "\n"
+       << "bottleneckHops " << params.bottleneckHops << "\n"
+       << "senderDelay " << params.senderDelay << "\n"
+       << "receiverDelay " << params.receiverDelay << "\n"
+       << "flowAccounting " << params.flowAccounting << "\n"
+       << "goodputBin " << params.goodputBin.GetTimeStep() << "\n"
+       << "warmup " << params.warmup.GetTimeStep() << "\n"
+       << "histogramBinWidth " << params.histogramBinWidth.GetTimeStep() << "\n"
+       << "pcap " << params.pcap << "\n"
+       << "snapLength " << params.pcapCapture.snapLength << "\n"
+       << "pcapSampleEvery " << params.pcapCapture.sampleEvery << "\n"
+       << "pcapDuration " << params.pcapCapture.captureFor.GetTimeStep() << "\n"
+       << "pcapRotateBytes " << params.pcapCapture.rotateBytes << "\n"
+       << "pcapRotateInterval " << params.pcapCapture.rotateInterval.GetTimeStep() << "\n"
+       << "pcapCompression " << params.pcapCapture.compression << "\n"
+       << "aggregation " << params.aggregation << "\n"
+       << "bufferBdp " << params.bufferBdp << "\n"
+       << "reportBuffers " << params.reportBuffers << "\n"
+       << "shortFlowLoad " << params.shortFlowLoad << "\n"
+       << "flowSizeCdf " << params.flowSizeCdf << "\n"
+       // Editing the file changes the results
+       << "flowSizeCdfHash "
+       << (params.flowSizeCdf.empty() ? "" : ResultCache::ComputeFileHash(params.flowSizeCdf))
+       << "\n"
+       << "shortFlowConnections " << params.shortFlowConnections << "\n"
+       << "shortFlowSlowStart " << params.shortFlowSlowStart << "\n";
+    return os.str();
+}
+
+// Name of one run, e.g. 100kB_10Mbps_50.0ms_TcpCubic
+std::string
+GetRunName(const SimulationParameters& params)
+{
+    std::string tcpTypeIdStr = params.tcpTypeId;
+    if (tcpTypeIdStr.rfind("ns3::", 0) == 0)
     {
-        BulkSendHelper source(socketFactory, InetSocketAddress(address, port + i));
-        source.SetAttribute("MaxBytes", UintegerValue(0));
-        ApplicationContainer sourceApps = source.Install(node);
-        sourceApps.Start(Seconds(1.0 + i * 0.1)); // Stagger the start times slightly
-        // Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceCwnd, nodeId, cwndWindow, port + i);
-        // Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceSsthresh, nodeId, cwndWindow, port + i);
-        sourceApps.Stop(stopTime+Seconds(i * 0.1)); // Ensure stopTime is set appropriately and staggered
+        tcpTypeIdStr = tcpTypeIdStr.substr(5);
     }
+    return params.qdiscSize + "_" + params.bottleneck_bandwidth + "_" + params.delay + "_" +
+           tcpTypeIdStr;
 }
-void InstallOnOff(Ptr<Node> node, Ipv4Address address, uint16_t port,
-                  std::string socketFactory,
-                  DataRate dataRate, uint16_t num_flows = 1, double stopTime = 60.0)
+
+// Directory holding the results of one run. Trials after the first go to
+// trial-<n>/ and aggregated runs to aggregation-<k>/ so that they do not
+// replace each other.
+std::string
+GetResultDir(const SimulationParameters& params)
 {
-    for (uint16_t i = 0; i < num_flows; ++i)
-    {
-        // Configure the OnOff application to send traffic to the specified address and port
-        OnOffHelper onOffHelper(socketFactory, InetSocketAddress(address, port + i));
-        onOffHelper.SetAttribute("DataRate", DataRateValue(dataRate));
-        onOffHelper.SetAttribute("PacketSize", UintegerValue(1448)); // Set packet size (default is 512 bytes)
-        onOffHelper.SetAttribute("OnTime",  StringValue("ns3::ConstantRandomVariable[Constant=1]"));
-        onOffHelper.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
+    std::string trialDir = params.trial > 1 ? "trial-" + std::to_string(params.trial) + "/" : "";
+    std::string aggregationDir =
+        params.aggregation > 1 ? "aggregation-" + std::to_string(params.aggregation) + "/" : "";
+    return params.dir + trialDir + aggregationDir + GetRunName(params) + "/";
+}
 
-        // Install the OnOff application on the specified node
-        ApplicationContainer sourceApps = onOffHelper.Install(node);
-        sourceApps.Start(Seconds(1.0 + i * 0.1)); // Stagger start times slightly
-        sourceApps.Stop(Seconds(stopTime + i * 0.1)); // Stagger stop times appropriately
+// Name of the job of a run in a sweep, and of its log file: its result
+// directory with '/' replaced by '.', so that the parallel trials and
+// aggregated runs of a row do not share a log
+std::string
+GetJobName(const SimulationParameters& params)
+{
+    std::string name = GetResultDir(params).substr(params.dir.size());
+    name.pop_back();
+    std::replace(name.begin(), name.end(), '/', '.');
+    return name;
+}
 
-        // Schedule tracing functions for congestion window and slow start threshold
-        // Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceCwnd, nodeId, cwndWindow, port + i);
-        // Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceSsthresh, nodeId, cwndWindow, port + i);
-    }
+// Where a run stopped by its watchdog keeps its results: below partial/,
+// which is not taken for a result directory
+std::string
+GetPartialDir(const SimulationParameters& params)
+{
+    return params.dir + "partial/" + GetResultDir(params).substr(params.dir.size());
 }
 
-//Receiver side
-// Function to install sink application
-void
-InstallPacketSink(Ptr<Node> node, uint16_t port, std::string socketFactory)
+// Heartbeat of a run: status/<job name>.txt
+std::string
+GetStatusFile(const SimulationParameters& params)
 {
-    PacketSinkHelper sink(socketFactory, InetSocketAddress(Ipv4Address::GetAny(), port));
-    ApplicationContainer sinkApps = sink.Install(node);
-    sinkApps.Start(Seconds(1.0));
-    sinkApps.Stop(stopTime);
+    return params.dir + "status/" + GetJobName(params) + ".txt";
 }
 
+// RNG run number of trial 1, from --RngRun
+uint64_t baseRngRun = 1;
 
-int
-main(int argc, char* argv[])
+// Every trial draws from its own independent RNG substreams. Must be called
+// before the cache key of a run is computed, which includes the run number.
+void
+SetTrialRun(const SimulationParameters& params)
 {
-    LogComponentEnable("BulkSendApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
-    LogComponentEnable("TcpL4Protocol", LOG_LEVEL_INFO);
+    RngSeedManager::SetRun(baseRngRun + params.trial - 1);
+}
 
+// Simulated work grows with the number of packets: bandwidth x duration
+double
+GetRunCost(const SimulationParameters& params)
+{
+    return DataRate(params.bottleneck_bandwidth).GetBitRate() * params.stopTime.GetSeconds();
+}
 
-    // uint32_t num_streams = 1;
-    std::string socketFactory = "ns3::TcpSocketFactory";
-    std::string tcpTypeId = "ns3::TcpCubic";
-    std::string qdiscTypeId = "ns3::FifoQueueDisc";
-    bool isSack = true;
-    uint32_t delAckCount = 1;
-    // std::string recovery = "ns3::TcpClassicRecovery";
-    std::string errorModelType = "ns3::RateErrorModel";
-    std::string qdiscSize = "0.1MB";
-    std::string delay = "4.8ms";
-    std::string bottleneck_bandwidth = "1.25Mbps";
-    std::string dir = "tcp-bbr-cubic-results/";
+// If the results of params are in the cache, link the result directory to
+// them and return their run statistics
+bool
+LinkCachedResult(const SimulationParameters& params, RunStats& stats)
+{
+    ResultCache cache(params.dir);
+    SetTrialRun(params);
+    std::string key = ResultCache::ComputeKey(DescribeParameters(params));
+    if (!params.useCache || !cache.Contains(key))
+    {
+        return false;
+    }
+    cache.Link(key, GetResultDir(params));
+    ReadRunStats(cache.GetEntryDir(key) + "run-stats.txt", stats);
+    return true;
+}
 
-    CommandLine cmd;
-    cmd.AddValue("tcpTypeId",
-                 "TCP variant to use (e.g., ns3::TcpNewReno, ns3::TcpLinuxReno, etc.)",
-                 tcpTypeId);
-    cmd.AddValue("qdiscTypeId", "Queue disc for gateway (e.g., ns3::CoDelQueueDisc, ns3::FifoQueueDisc)", qdiscTypeId);
-    cmd.AddValue("segmentSize", "TCP segment size (bytes)", segmentSize);
-    cmd.AddValue("delAckCount", "Delayed ack count", delAckCount);
-    cmd.AddValue("enableSack", "Flag to enable/disable sack in TCP", isSack);
-    cmd.AddValue("stopTime",
-                 "Stop time for applications / simulation time will be stopTime",
-                 stopTime);
-    // cmd.AddValue("recovery", "Recovery algorithm type to use (e.g., ns3::TcpPrrRecovery", recovery);
-    cmd.AddValue("qdiscSize", "Size of the queue", qdiscSize);
-    cmd.AddValue("delay", "Delay of the link", delay);
-    cmd.AddValue("bottleneck_bandwidth", "Bandwidth of the bottleneck link", bottleneck_bandwidth);
-    cmd.AddValue("dir", "Directory to store the results", dir);
-    cmd.Parse(argc, argv);
+// Super-segments of aggregation segments must fit an IP packet of 64 KB
+bool
+IsValidAggregation(const SimulationParameters& params)
+{
+    return params.aggregation >= 1 && params.segmentSize * params.aggregation + 52 <= 65535;
+}
 
-    // --dir="output_${qdiscSize}_${bottleneck_bandwidth}_${delay}_${tcpTypeId}_${trial}" 
-    std::string tcpTypeIdStr;
-    if (tcpTypeId == "ns3::TcpCubic"){
-        tcpTypeIdStr = "TcpCubic";
-    } else if (tcpTypeId == "ns3::TcpBbr" ){
-        tcpTypeIdStr = "TcpBbr";
+// Read the rows of a sweep file (e.g. parameters.csv). Columns are matched by
+// the names in the header line; any parameter not present in the file keeps
+// the value given in defaults (i.e. on the command line).
+std::vector<SimulationParameters>
+ReadParameterRows(const std::string& csvFile, const SimulationParameters& defaults)
+{
+    std::ifstream in(csvFile);
+    NS_ABORT_MSG_UNLESS(in.is_open(), "Cannot open sweep file " << csvFile);
+
+    auto split = [](const std::string& line) {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ','))
+        {
+            field.erase(0, field.find_first_not_of(" \t\r"));
+            field.erase(field.find_last_not_of(" \t\r") + 1);
+            fields.push_back(field);
+        }
+        return fields;
+    };
+
+    std::string line;
+    NS_ABORT_MSG_UNLESS(std::getline(in, line), "Sweep file " << csvFile << " is empty");
+    std::vector<std::string> header = split(line);
+
+    std::vector<SimulationParameters> rows;
+    while (std::getline(in, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+        std::vector<std::string> fields = split(line);
+        NS_ABORT_MSG_UNLESS(fields.size() == header.size(),
+                            "Malformed row in " << csvFile << ": " << line);
+
+        SimulationParameters row = defaults;
+        for (std::size_t i = 0; i < header.size(); ++i)
+        {
+            const std::string& name = header[i];
+            const std::string& value = fields[i];
+            if (name == "qdiscSize")
+            {
+                row.qdiscSize = value;
+            }
+            else if (name == "bottleneck_bandwidth")
+            {
+                row.bottleneck_bandwidth = value;
+            }
+            else if (name == "delay")
+            {
+                row.delay = value;
+            }
+            else if (name == "numFlows")
+            {
+                row.numFlows = std::stoul(value);
+            }
+            else if (name == "tcpTypeId")
+            {
+                // parameters.csv stores the short name (TcpCubic, TcpBbr)
+                row.tcpTypeId = value.rfind("ns3::", 0) == 0 ? value : "ns3::" + value;
+            }
+            else if (name == "qdiscTypeId")
+            {
+                row.qdiscTypeId = value.rfind("ns3::", 0) == 0 ? value : "ns3::" + value;
+            }
+            else if (name == "segmentSize")
+            {
+                row.segmentSize = std::stoul(value);
+            }
+            else if (name == "delAckCount")
+            {
+                row.delAckCount = std::stoul(value);
+            }
+            else if (name == "enableSack")
+            {
+                row.isSack = (value == "1" || value == "true");
+            }
+            else if (name == "stopTime")
+            {
+                row.stopTime = Time(value);
+            }
+            else if (name == "trial")
+            {
+                row.trial = std::stoul(value);
+            }
+            else if (name == "aggregation")
+            {
+                row.aggregation = std::stoul(value);
+            }
+            else if (name == "shortFlowLoad")
+            {
+                row.shortFlowLoad = std::stod(value);
+            }
+        }
+        NS_ABORT_MSG_UNLESS(IsValidAggregation(row),
+                            "Row in " << csvFile << " with aggregation " << row.aggregation
+                                      << " does not fit a super-segment in 64 KB: " << line);
+        rows.push_back(row);
     }
-    
-    dir = dir  + qdiscSize + "_" + bottleneck_bandwidth + "_" + delay + "_" + tcpTypeIdStr + "/";
+    return rows;
+}
 
+// Build the dumbbell, run it and write the results of one parameter set.
+// Everything created here is torn down by Simulator::Destroy() at the end, so
+// the function can be called repeatedly from the same process.
+RunStats
+RunSimulation(const SimulationParameters& params)
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    RunStats runStats;
+    if (LinkCachedResult(params, runStats))
+    {
+        std::cout << "Results of " << GetRunName(params) << " are cached in "
+                  << GetResultDir(params) << std::endl;
+        return runStats;
+    }
+    // Peak memory of this run, not of the rows run before it in this process
+    bool runPeakRss = ResetPeakRss();
+    stopTime = params.stopTime;
+    // TCP segments are super-segments of params.aggregation segments
+    segmentSize = params.segmentSize * params.aggregation;
+
+    // Results are written to a temporary cache entry that is published when complete
+    ResultCache cache(params.dir);
+    SetTrialRun(params);
+    std::string config = DescribeParameters(params);
+    std::string key = ResultCache::ComputeKey(config);
+    std::string dir = cache.BeginEntry(key);
+    // The result directory may still point at an older entry (another build,
+    // or a forced re-run); if this run fails, its run-stats.txt must not be
+    // taken for this one
+    cache.Unlink(GetResultDir(params));
+
+    // Heartbeat of the run and its limits, from here on
+    if (params.heartbeat > 0)
+    {
+        SystemPath::MakeDirectories(params.dir + "status/");
+    }
+    RunWatchdog watchdog(GetStatusFile(params),
+                         params.heartbeat,
+                         params.maxWallTime,
+                         params.maxRss * 1024);
+
+    // Global state that outlives Simulator::Destroy(). Resetting it makes a
+    // run inside a sweep identical to a standalone run of the same row.
+    Ipv4AddressGenerator::Reset();
+    RngSeedManager::ResetNextStreamIndex();
+
+    // One bucket of BucketCalendarScheduler per packet on the bottleneck, and
+    // a ring covering about two RTTs
+    std::string scheduler = GetSchedulerTypeId(params.scheduler);
+    if (scheduler == "ns3::BucketCalendarScheduler")
+    {
+        ConfigureBucketScheduler(DataRate(params.bottleneck_bandwidth),
+                                 segmentSize + 54,
+                                 Time(params.delay) * int64_t(4 * (params.bottleneckHops + 2)));
+    }
+
+    // Wall-clock profile of the event loop, written to profile.txt
+    EventProfiler profiler;
+    if (params.profile)
+    {
+        ProfilingScheduler::SetProfiler(&profiler);
+        ObjectFactory factory("ns3::ProfilingScheduler");
+        factory.Set("Inner", StringValue(scheduler));
+        Simulator::SetScheduler(factory);
+    }
+    else
+    {
+        Simulator::SetScheduler(ObjectFactory(scheduler));
+    }
 
     // TypeId qdTid;
     // NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(qdiscTypeId, &qdTid),
@@ -190,127 +515,199 @@ main(int argc, char* argv[])
     // Config::SetDefault("ns3::TcpL4Protocol::RecoveryType",
     //                    TypeIdValue(TypeId::LookupByName(recovery)));
     TypeId tcpTid;
-    NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(tcpTypeId, &tcpTid),
-                        "TypeId " << tcpTypeId << " not found");
+    NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(params.tcpTypeId, &tcpTid),
+                        "TypeId " << params.tcpTypeId << " not found");
     Config::SetDefault("ns3::TcpL4Protocol::SocketType",
-                       TypeIdValue(TypeId::LookupByName(tcpTypeId)));
-
+                       TypeIdValue(TypeId::LookupByName(params.tcpTypeId)));
 
-    // Set default sender and receiver buffer size as 1MB
-    Config::SetDefault("ns3::TcpSocket::SndBufSize", UintegerValue(1<<30));
-    Config::SetDefault("ns3::TcpSocket::RcvBufSize", UintegerValue(1<<30));
 
-    // Set default initial congestion window as 10 segments
-    Config::SetDefault("ns3::TcpSocket::InitialCwnd", UintegerValue(10));
+    // Set default initial congestion window as 10 segments (of the same
+    // bytes when they are aggregated)
+    Config::SetDefault("ns3::TcpSocket::InitialCwnd",
+                       UintegerValue((10 + params.aggregation - 1) / params.aggregation));
 
     // Config::SetDefault("ns3::TcpSocket::InitialSlowStartThreshold", UintegerValue(segmentSize*10));
 
     // Set default delayed ack count to a specified value
-    Config::SetDefault("ns3::TcpSocket::DelAckCount", UintegerValue(delAckCount));
+    Config::SetDefault("ns3::TcpSocket::DelAckCount", UintegerValue(params.delAckCount));
 
     // Set default segment size of TCP packet to a specified value
     Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(segmentSize));
     Config::SetDefault("ns3::DropTailQueue<Packet>::MaxSize", QueueSizeValue(QueueSize("1p")));
+    // Super-segments must not be fragmented by IP. Set for every run, as the
+    // default outlives a run inside a sweep.
+    uint32_t mtu = params.aggregation > 1 ? segmentSize + 52 : 1500;
+    Config::SetDefault("ns3::PointToPointNetDevice::Mtu", UintegerValue(mtu));
 
     // Enable/Disable SACK in TCP
-    Config::SetDefault("ns3::TcpSocketBase::Sack", BooleanValue(isSack));
-
-    // Create nodes
-    NodeContainer leftNode;
-    NodeContainer rightNode;
-    NodeContainer router;
-    router.Create(1);
-    leftNode.Create(1);
-    rightNode.Create(1);
-
-    // Create the point-to-point link helpers and connect two router nodes
-    PointToPointHelper accessLink;
-    accessLink.SetDeviceAttribute("DataRate", StringValue("10Gbps"));
-    accessLink.SetChannelAttribute("Delay", StringValue(delay));
-    // accessLink.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("1p")));
-
-    PointToPointHelper bottleneckLink;
-    bottleneckLink.SetDeviceAttribute("DataRate", StringValue(bottleneck_bandwidth));
-    bottleneckLink.SetChannelAttribute("Delay", StringValue(delay));
-    bottleneckLink.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("1p")));
-    
-    NetDeviceContainer leftToRouter = accessLink.Install(leftNode.Get(0), router.Get(0));
-    NetDeviceContainer routerToRight = bottleneckLink.Install(router.Get(0), rightNode.Get(0));
-
-    InternetStackHelper internetStack;
-
-    internetStack.Install(leftNode);
-    internetStack.Install(rightNode);
-    internetStack.Install(router);
-
-    // Assign IP addresses to all the network devices
-    Ipv4AddressHelper ipAddresses("10.0.0.0", "255.255.255.0");
-
-    std::vector<Ipv4InterfaceContainer> leftToRouterIPAddress;
-    std::vector<Ipv4InterfaceContainer> routerToRightIPAddress;
+    Config::SetDefault("ns3::TcpSocketBase::Sack", BooleanValue(params.isSack));
+
+    // Create the dumbbell: senders, routers, receivers and their static routes
+    auto topologyStart = std::chrono::steady_clock::now();
+    DumbbellConfig dumbbell;
+    dumbbell.senders = params.senders;
+    dumbbell.receivers = params.receivers;
+    dumbbell.bottleneckHops = params.bottleneckHops;
+    dumbbell.bottleneckRate = params.bottleneck_bandwidth;
+    dumbbell.bottleneckDelay = params.delay;
+    dumbbell.senderDelay = params.senderDelay.empty() ? params.delay : params.senderDelay;
+    dumbbell.receiverDelay = params.receiverDelay.empty() ? params.delay : params.receiverDelay;
+    DumbbellTopology topology(dumbbell);
+
+    // Set default sender and receiver buffer size as 1GB, or from the
+    // bandwidth-delay product (at least the ns-3 default of 128 KiB)
+    uint32_t socketBuffer = 1 << 30;
+    if (params.bufferBdp > 0)
+    {
+        double bdp = DataRate(params.bottleneck_bandwidth).GetBitRate() / 8.0 *
+                     topology.GetMaxPropagationRtt().GetSeconds();
+        socketBuffer = std::clamp(params.bufferBdp * bdp, 131072.0, double(1 << 30));
+    }
+    Config::SetDefault("ns3::TcpSocket::SndBufSize", UintegerValue(socketBuffer));
+    Config::SetDefault("ns3::TcpSocket::RcvBufSize", UintegerValue(socketBuffer));
+    double topologySeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - topologyStart).count();
 
-    leftToRouterIPAddress.push_back(ipAddresses.Assign(leftToRouter));
     
-    ipAddresses.NewNetwork();
-    routerToRightIPAddress.push_back(ipAddresses.Assign(routerToRight));
 
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    // Tracers built into this program, see trace-policies.h
+    ConfiguredTracers tracers;
 
-    
-
-    // Create directories to store dat files
-    struct stat buffer;
-    int retVal [[maybe_unused]];
-    if ((stat(dir.c_str(), &buffer)) == 0)
+    // Install flow monitor on all the nodes, unless the results are taken at
+    // the endpoints only
+    bool flowMonitor =
+        decltype(tracers.flowStats)::enabled && params.flowAccounting != "endpoint";
+    if (flowMonitor)
     {
-        std::string dirToRemove = "rm -rf " + dir;
-        retVal = system(dirToRemove.c_str());
-        NS_ASSERT_MSG(retVal == 0, "Error in return value");
+        tracers.flowStats.Install(params.histogramBinWidth);
     }
 
-    SystemPath::MakeDirectories(dir);
-    // SystemPath::MakeDirectories(dir + "/pcap/");
-    SystemPath::MakeDirectories(dir + "/queueTraces/");
-    // SystemPath::MakeDirectories(dir + "/cwndTraces/");
-
-    // Install flow monitor on all the nodes
-    FlowMonitorHelper flowHelper;
-    Ptr<FlowMonitor> monitor = flowHelper.InstallAll();
-
 
     // Install queue discipline on router
     TrafficControlHelper tch;
-    tch.SetRootQueueDisc(qdiscTypeId, "MaxSize", QueueSizeValue(QueueSize(qdiscSize)));
+    // A queue limit in packets counts segments: k times fewer super-segments
+    QueueSize queueSize(params.qdiscSize);
+    if (queueSize.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        uint32_t packets = (queueSize.GetValue() + params.aggregation - 1) / params.aggregation;
+        queueSize = QueueSize(QueueSizeUnit::PACKETS, packets);
+    }
+    tch.SetRootQueueDisc(params.qdiscTypeId, "MaxSize", QueueSizeValue(queueSize));
     QueueDiscContainer qd;
-    tch.Uninstall(leftToRouter.Get(1));
-    tch.Uninstall(routerToRight.Get(0));
-    tch.Install(leftToRouter.Get(1));
-    qd = tch.Install(routerToRight.Get(0));
-
-
-    // Open files for writing queue size and cwnd traces
-    fPlotQueue.open(dir + "queue-size.dat", std::ios::out);
-    // fPlotCwnd.open(dir + "cwndTraces/n0.dat", std::ios::out);
-    // fPlotSsthresh.open(dir + "cwndTraces/ssthresh.dat", std::ios::out);
-
-    // Calls function to check queue size
-    Simulator::ScheduleNow(&CheckQueueSize, qd.Get(0));
-
-    AsciiTraceHelper asciiTraceHelper;
-    Ptr<OutputStreamWrapper> streamWrapper;
+    tch.Uninstall(topology.GetSenderGatewayDevices());
+    tch.Uninstall(topology.GetBottleneckDevices());
+    tch.Install(topology.GetSenderGatewayDevices());
+    // qd.Get(0) is the first bottleneck, which is the one traced
+    qd = tch.Install(topology.GetBottleneckDevices());
+
+
+    // Trace files are written by a background thread unless asyncTraces is off
+    TraceOutputThread traceOutput;
+    traceOutput.CloseOnDestroy();
+    TraceOpener openTrace = [&](const std::string& basePath,
+                                const std::string& name,
+                                const std::string& unit,
+                                const std::string& textSuffix) {
+        std::unique_ptr<TraceWriter> writer =
+            CreateTraceWriter(params.traceFormat, basePath, name, unit, textSuffix);
+        return params.asyncTraces ? traceOutput.Wrap(std::move(writer)) : std::move(writer);
+    };
+
+    // Track the queue size of the bottleneck; queue-size.dat keeps the sampled
+    // trace for plotting
+    QueueOccupancyTracker queueTracker(qd.Get(0), segmentSize);
+    if (params.queueSampleInterval.IsStrictlyPositive())
+    {
+        tracers.queue.Install(openTrace, dir, qd.Get(0), params.queueSampleInterval, queueTracker);
+    }
 
     // // Create dat to store packets dropped and marked at the router
-    streamWrapper = asciiTraceHelper.CreateFileStream(dir + "/queueTraces/drop-0.dat");
-    qd.Get(0)->TraceConnectWithoutContext("Drop", MakeBoundCallback(&DropAtQueue, streamWrapper));
+    tracers.drop.Install(openTrace, dir, qd.Get(0));
+
+    if (params.traceCwnd || params.traceBbr)
+    {
+        // In segments of params.segmentSize, also when TCP sends super-segments,
+        // so that traces of aggregated runs compare with per-packet ones
+        tracers.cwnd.Install(params.cwndSampleInterval, params.segmentSize, params.traceBbr);
+    }
 
     // Install packet sink at receiver side
     uint16_t port = 50000;
-    InstallPacketSink(rightNode.Get(0), port, "ns3::TcpSocketFactory");
-    
-    // Install BulkSend application
+    // Sender i sends numFlows flows to receiver i % receivers, on ports
+    // port + i * numFlows onwards
+    std::unique_ptr<EndpointAccounting> accounting;
+    std::vector<FlowObserver*> observers;
+    tracers.cwnd.AddTo(observers);
+    // Traces every segment, so only when the buffers are sized or reported
+    std::unique_ptr<SocketBufferTracker> buffers;
+    if (params.bufferBdp > 0 || params.reportBuffers)
+    {
+        buffers = std::make_unique<SocketBufferTracker>();
+        observers.push_back(buffers.get());
+    }
+    if (params.flowAccounting != "flowmonitor" || !flowMonitor)
+    {
+        accounting = std::make_unique<EndpointAccounting>();
+        observers.push_back(accounting.get());
+    }
+    NS_ABORT_MSG_UNLESS(port + uint64_t(params.senders) * params.numFlows <= 65536,
+                        "Too many flows for the port range starting at " << port);
+    ApplicationContainer sinkApps;
+    GoodputSampler goodput(Seconds(1.0), stopTime, params.goodputBin, params.warmup);
+    for (uint32_t i = 0; i < params.senders; ++i)
+    {
+        uint32_t receiver = i % params.receivers;
+        uint16_t senderPort = port + i * params.numFlows;
+        ApplicationContainer sinks = InstallPacketSink(topology.GetReceivers().Get(receiver),
+                                                       senderPort,
+                                                       "ns3::TcpSocketFactory",
+                                                       stopTime,
+                                                       params.numFlows);
+        for (uint32_t j = 0; j < sinks.GetN(); ++j)
+        {
+            goodput.Add(DynamicCast<PacketSink>(sinks.Get(j)));
+            if (buffers)
+            {
+                buffers->AddSink(DynamicCast<PacketSink>(sinks.Get(j)));
+            }
+            if (accounting)
+            {
+                accounting->AddSink(senderPort + j, DynamicCast<PacketSink>(sinks.Get(j)));
+            }
+        }
+        sinkApps.Add(sinks);
+
+        // Install BulkSend application
+        InstallBulkSend(topology.GetSenders().Get(i), topology.GetReceiverAddress(receiver),
+                        senderPort, params.socketFactory, stopTime, params.numFlows, observers,
+                        params.flowStagger, params.startJitter);
+    }
 
-    InstallBulkSend(leftNode.Get(0), routerToRightIPAddress[0].GetAddress(1), port,
-                        socketFactory, 1);
+    // Short flows from random senders to receiver sender % receivers, over
+    // persistent connections to a port below those of the long flows
+    uint16_t shortFlowPort = 40000;
+    std::unique_ptr<ShortFlowWorkload> shortFlows;
+    if (params.shortFlowLoad > 0)
+    {
+        std::vector<Ipv4Address> receiverAddresses;
+        for (uint32_t i = 0; i < params.receivers; ++i)
+        {
+            receiverAddresses.push_back(topology.GetReceiverAddress(i));
+        }
+        shortFlows = std::make_unique<ShortFlowWorkload>(
+            params.flowSizeCdf.empty() ? GetWebSearchFlowSizes()
+                                       : ReadFlowSizeCdf(params.flowSizeCdf),
+            shortFlowPort,
+            params.shortFlowConnections,
+            params.shortFlowSlowStart);
+        shortFlows->Install(topology.GetSenders(),
+                            topology.GetReceivers(),
+                            receiverAddresses,
+                            params.shortFlowLoad,
+                            DataRate(params.bottleneck_bandwidth),
+                            Seconds(1.0),
+                            stopTime);
+    }
 
     // // Install OnOff application
     // InstallOnOff(leftNode.Get(0), routerToRightIPAddress[0].GetAddress(1), port,
@@ -327,41 +724,117 @@ main(int argc, char* argv[])
 
 
     // Enable PCAP on all the point to point interfaces
-    // accessLink.EnablePcapAll(dir + "pcap/ns-3", true);
+    if (params.pcap)
+    {
+        tracers.pcap.Install(dir, params.pcapCapture);
+    }
+
+    std::unique_ptr<ConvergenceController> convergence;
+    if (params.convergenceTolerance > 0)
+    {
+        convergence = std::make_unique<ConvergenceController>(sinkApps,
+                                                              &queueTracker,
+                                                              params.convergenceWindow,
+                                                              params.convergenceBatches,
+                                                              params.convergenceTolerance,
+                                                              params.convergenceQueueTolerance,
+                                                              params.convergenceMinTime);
+        convergence->Start(Seconds(1.0));
+    }
 
     Simulator::Stop(stopTime);
+    runStats.setupWallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    runStats.setupRssKb = GetPeakRssKb();
+    std::cout << "Setup: topology of " << NodeList::GetNNodes() << " nodes in "
+              << topologySeconds * 1e3 << " ms, " << runStats.setupWallSeconds * 1e3
+              << " ms in total, " << runStats.setupRssKb << " kB peak RSS" << std::endl;
+    watchdog.Start(stopTime);
+    profiler.Start();
+    auto runStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    watchdog.End();
+    runStats.runWallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    profiler.Stop();
+    // The watchdog checks run at wall-clock intervals and differ from run to run
+    runStats.events = Simulator::GetEventCount() - watchdog.GetCheckEvents();
+    runStats.simulatedSeconds = Simulator::Now().GetSeconds();
+    queueTracker.Finish();
+    goodput.Finish();
+    // Shorter than stopTime if the run was ended early
+    Time simulatedTime = Simulator::Now();
 
-    monitor->CheckForLostPackets(); // Optional, helps in accounting for lost packets
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowHelper.GetClassifier());
-    std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats();
     std::ofstream resultFile;
     resultFile.open(dir + "goodput_retransmission_results.txt", std::fstream::out);
-    for(std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
-    {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
-        resultFile << "Flow " << i->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
-        std::cout << "Flow " << i->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
-        resultFile << "  Tx Bytes:   " << i->second.txBytes << "\n";
-        std::cout << "  Tx Bytes:   " << i->second.txBytes << "\n";
-        resultFile << "  Rx Bytes:   " << i->second.rxBytes << "\n";
-        std::cout << "  Rx Bytes:   " << i->second.rxBytes << "\n";
-        resultFile << "  Tx Packets: " << i->second.txPackets << "\n";
-        std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
-        resultFile << "  Rx Packets: " << i->second.rxPackets << "\n";
-        std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
-        resultFile << "  Lost Packets: " << i->second.lostPackets << "\n";
-        std::cout << "  Lost Packets: " << i->second.lostPackets << "\n";
-        resultFile << "  Throughput: " << i->second.rxBytes * 8.0 / stopTime.GetSeconds() / 1024 / 1024  << " Mbps\n";
-        std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / stopTime.GetSeconds() / 1024 / 1024  << " Mbps\n";
-        uint32_t retransmissions = i->second.txPackets - i->second.rxPackets - i->second.lostPackets;
-        resultFile << "  Retransmissions: " << retransmissions << "\n";
-        std::cout << "  Retransmissions: " << retransmissions << "\n";
-        resultFile << "  Average Delay: " << i->second.delaySum.GetSeconds() / i->second.rxPackets << "\n";
-        std::cout << "  Average Delay: " << i->second.delaySum.GetSeconds() / i->second.rxPackets << "\n";
+    if (flowMonitor)
+    {
+        // Delay and jitter histograms of every flow, to merge trials later
+        std::ofstream histogramFile(dir + "delayHistograms.txt");
+        std::ostringstream flowResults;
+        tracers.flowStats.Write(flowResults,
+                                &histogramFile,
+                                simulatedTime,
+                                shortFlows ? shortFlowPort : 0);
+        resultFile << flowResults.str();
+        std::cout << flowResults.str();
+    }
+    if (accounting)
+    {
+        // Without FlowMonitor these are the results; otherwise they are kept
+        // next to them for comparison
+        std::ofstream endpointFile;
+        std::ostream& os = flowMonitor ? endpointFile : resultFile;
+        if (flowMonitor)
+        {
+            endpointFile.open(dir + "endpoint_results.txt", std::fstream::out);
+        }
+        accounting->Write(os, simulatedTime);
+        if (!flowMonitor)
+        {
+            accounting->Write(std::cout, simulatedTime);
+        }
     }
+    goodput.Print(resultFile);
+    goodput.Print(std::cout);
+    // Memory: socket buffers, how full they got and the peak of the process
+    for (std::ostream* os : {static_cast<std::ostream*>(&resultFile), &std::cout})
+    {
+        *os << "Socket buffers: " << socketBuffer << " bytes\n";
+        if (buffers)
+        {
+            buffers->Print(*os);
+        }
+        *os << (runPeakRss ? "Peak RSS: " : "Peak RSS of the process: ") << GetPeakRssKb()
+            << " kB\n";
+    }
+    if (convergence)
+    {
+        convergence->Print(resultFile);
+        convergence->Print(std::cout);
+    }
+    if (shortFlows)
+    {
+        shortFlows->Print(resultFile);
+        shortFlows->Print(std::cout);
+        std::ofstream fctFile(dir + "flowCompletionTimes.txt");
+        shortFlows->Write(fctFile);
+    }
+    watchdog.Print(resultFile);
+    watchdog.Print(std::cout);
     resultFile.close();
 
+    // Goodput of all flows together in every bin
+    std::unique_ptr<TraceWriter> goodputTrace = openTrace(dir + "goodput", "goodput", "bps", "");
+    goodput.Write(goodputTrace.get());
+    goodputTrace->Close();
+
+    tracers.cwnd.Finish(params.traceFormat, dir);
+    if (decltype(tracers.cwnd)::enabled && params.traceBbr && params.tcpTypeId == "ns3::TcpBbr")
+    {
+        std::ofstream bbrStats(dir + "bbrStats.txt");
+        tracers.cwnd.Write(bbrStats);
+    }
 
     // Store queue stats in a file
     std::ofstream myfile;
@@ -369,21 +842,1319 @@ main(int argc, char* argv[])
     myfile << std::endl;
     myfile << "Stat for Queue 1";
     myfile << qd.Get(0)->GetStats();
+    if (params.aggregation > 1)
+    {
+        // A dropped super-segment stands for aggregation lost segments
+        uint64_t droppedBytes = qd.Get(0)->GetStats().nTotalDroppedBytes;
+        myfile << "\nDropped segments (estimated): "
+               << droppedBytes * params.aggregation / (segmentSize + 54);
+    }
+    myfile << "\nOccupancy of Queue 1\n";
+    queueTracker.Print(myfile);
     myfile.close();
 
     // Store configuration of the simulation in a file
     myfile.open(dir + "config.txt", std::fstream::in | std::fstream::out | std::fstream::app);
-    myfile << "qdiscTypeId " << qdiscTypeId << "\n";
+    myfile << "qdiscTypeId " << params.qdiscTypeId << "\n";
     // myfile << "stream  " << num_streams << "\n";
     myfile << "segmentSize " << segmentSize << "\n";
-    myfile << "delAckCount " << delAckCount << "\n";
+    if (params.aggregation > 1)
+    {
+        myfile << "aggregation " << params.aggregation << "\n";
+    }
+    myfile << "delAckCount " << params.delAckCount << "\n";
     myfile << "stopTime " << stopTime.As(Time::S) << "\n";
+    if (convergence || watchdog.HasTripped())
+    {
+        myfile << "simulatedTime " << simulatedTime.As(Time::S) << "\n";
+    }
     myfile.close();
 
+    if (params.profile)
+    {
+        myfile.open(dir + "profile.txt", std::fstream::out);
+        profiler.Write(myfile, Simulator::Now(), topology.GetNodeLabels());
+        myfile.close();
+        ProfilingScheduler::SetProfiler(nullptr);
+    }
+
+    // Also writes out and closes the trace files
     Simulator::Destroy();
 
-    // fPlotQueue.close();
-    // fPlotCwnd.close();
+    tracers.drop.Finish();
+    tracers.queue.Finish();
+    tracers.pcap.Finish();
+    if (traceOutput.GetStalls() > 0 || traceOutput.GetDropped() > 0)
+    {
+        std::cout << "Trace output: " << traceOutput.GetStalls() << " stalled writes, "
+                  << traceOutput.GetDropped() << " dropped records" << std::endl;
+    }
+
+    runStats.peakRssKb = GetPeakRssKb();
+    runStats.traceBytes = GetDirectorySize(dir);
+    runStats.wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    runStats.aborted = watchdog.HasTripped();
+    WriteRunStats(dir + "run-stats.txt", runStats);
+    // Partial results are kept for a look but never taken for the run
+    std::string resultDir = runStats.aborted ? GetPartialDir(params) : GetResultDir(params);
+    if (runStats.aborted)
+    {
+        cache.KeepPartial(dir, resultDir);
+        std::cout << "Partial results of " << GetRunName(params) << " are in " << resultDir
+                  << std::endl;
+    }
+    else
+    {
+        cache.CommitEntry(key, dir, config);
+        cache.Link(key, resultDir);
+    }
+    watchdog.Finish(resultDir);
+    return runStats;
+}
+
+
+// Simulate params as a job of RunSweepInParallel(): its exit status
+int
+RunJob(const SimulationParameters& params)
+{
+    return RunSimulation(params).aborted ? SWEEP_JOB_ABORTED : 0;
+}
+
+// Simulate the rows that are not cached yet, on workers forked processes (1 =
+// one after another in this process). Returns the number of failed rows,
+// including those stopped by their watchdog.
+uint32_t
+RunRows(const std::vector<SimulationParameters>& rows,
+        uint32_t workers,
+        uint32_t retries,
+        const std::string& logDir)
+{
+    std::vector<SweepJob> jobs;
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        // Rows whose results are cached are not re-run
+        RunStats cached;
+        if (LinkCachedResult(rows[i], cached))
+        {
+            std::cout << "Results of " << GetResultDir(rows[i]) << " are cached. Skipping..."
+                      << std::endl;
+            continue;
+        }
+        jobs.push_back({i, GetRunCost(rows[i]), GetJobName(rows[i])});
+    }
+
+    if (workers == 1)
+    {
+        uint32_t aborted = 0;
+        for (std::size_t j = 0; j < jobs.size(); ++j)
+        {
+            std::cout << "Row " << j + 1 << "/" << jobs.size() << ": " << jobs[j].name << std::endl;
+            aborted += RunSimulation(rows[jobs[j].row]).aborted;
+        }
+        return aborted;
+    }
+
+    return RunSweepInParallel(
+        jobs,
+        [&rows](std::size_t row) { return RunJob(rows[row]); },
+        workers,
+        retries,
+        logDir);
+}
+
+// One flow block of goodput_retransmission_results.txt
+struct FlowResult
+{
+    std::string source;        // address of the sending node
+    double throughput{0};      // Mbps
+    double retransmissions{0}; // may be negative with FlowMonitor, see below
+    double delay{-1};          // average one-way delay in s, -1 if not reported
+    double rxPackets{0};
+};
+
+// The flow blocks of goodput_retransmission_results.txt, in file order
+std::vector<FlowResult>
+ReadFlowResults(const SimulationParameters& params)
+{
+    std::ifstream in(GetResultDir(params) + "goodput_retransmission_results.txt");
+    std::vector<FlowResult> flows;
+    std::string line;
+    auto valueAfter = [&line](const std::string& label, double& value) {
+        std::size_t pos = line.find(label);
+        if (pos == std::string::npos)
+        {
+            return false;
+        }
+        value = std::stod(line.substr(pos + label.size()));
+        return true;
+    };
+    // FlowMonitor counts packets; Tx - Rx - Lost is signed here, as older
+    // results wrapped it around as an unsigned 32-bit value
+    double txPackets = -1;
+    double lostPackets = 0;
+    auto endFlow = [&]() {
+        if (!flows.empty() && txPackets >= 0)
+        {
+            FlowResult& flow = flows.back();
+            flow.retransmissions = txPackets - flow.rxPackets - lostPackets;
+        }
+        txPackets = -1;
+        lostPackets = 0;
+    };
+    while (std::getline(in, line))
+    {
+        if (line.compare(0, 5, "Flow ") == 0)
+        {
+            // Flow <id> (<source> -> <destination>)
+            std::size_t open = line.find('(');
+            std::size_t arrow = line.find(" -> ");
+            endFlow();
+            flows.emplace_back();
+            if (open != std::string::npos && arrow != std::string::npos)
+            {
+                flows.back().source = line.substr(open + 1, arrow - open - 1);
+            }
+            continue;
+        }
+        if (flows.empty() || line.compare(0, 2, "  ") != 0)
+        {
+            continue;
+        }
+        FlowResult& flow = flows.back();
+        if (!valueAfter("Throughput: ", flow.throughput) &&
+            !valueAfter("Retransmissions: ", flow.retransmissions) &&
+            !valueAfter("Average Delay: ", flow.delay) && !valueAfter("Tx Packets: ", txPackets) &&
+            !valueAfter("Rx Packets: ", flow.rxPackets))
+        {
+            valueAfter("Lost Packets: ", lostPackets);
+        }
+    }
+    endFlow();
+    return flows;
+}
+
+// Flows from the senders (10.1.0.0/16 in the dumbbell topology), without the
+// reverse flows of their ACKs
+bool
+IsDataFlow(const FlowResult& flow)
+{
+    return flow.source.compare(0, 5, "10.1.") == 0;
+}
+
+// Goodput of all data flows together in goodput_retransmission_results.txt,
+// in Mbps
+bool
+ReadGoodput(const SimulationParameters& params, double& goodput)
+{
+    bool found = false;
+    goodput = 0;
+    for (const FlowResult& flow : ReadFlowResults(params))
+    {
+        if (IsDataFlow(flow))
+        {
+            goodput += flow.throughput;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Results of one trial that the replication statistics are taken over
+struct TrialMetrics
+{
+    double goodput{0};         // Mbps of all flows over the active period
+    double retransmissions{0}; // of all data flows
+    double delay{0};           // average one-way delay of the data packets, s
+    double queue{0};           // time-average occupancy of the bottleneck queue
+};
+
+bool
+ReadTrialMetrics(const SimulationParameters& params, TrialMetrics& metrics)
+{
+    std::string resultDir = GetResultDir(params);
+    std::ifstream in(resultDir + "goodput_retransmission_results.txt");
+    std::string line;
+    bool goodput = false;
+    metrics = TrialMetrics();
+    auto valueAfter = [&line](const std::string& label, double& value) {
+        std::size_t pos = line.find(label);
+        if (pos == std::string::npos)
+        {
+            return false;
+        }
+        value = std::stod(line.substr(pos + label.size()));
+        return true;
+    };
+    while (std::getline(in, line))
+    {
+        if (valueAfter("Active Goodput: ", metrics.goodput))
+        {
+            goodput = true;
+            break;
+        }
+    }
+    // Delay averaged over the received packets of all data flows
+    double delaySum = 0;
+    double packets = 0;
+    for (const FlowResult& flow : ReadFlowResults(params))
+    {
+        if (!IsDataFlow(flow))
+        {
+            continue;
+        }
+        metrics.retransmissions += flow.retransmissions;
+        if (flow.delay >= 0 && flow.rxPackets > 0)
+        {
+            delaySum += flow.delay * flow.rxPackets;
+            packets += flow.rxPackets;
+        }
+    }
+    metrics.delay = packets > 0 ? delaySum / packets : 0;
+    std::ifstream queueStats(resultDir + "queueStats.txt");
+    while (std::getline(queueStats, line))
+    {
+        if (valueAfter("Time-average: ", metrics.queue))
+        {
+            break;
+        }
+    }
+    return goodput;
+}
+
+// Whether the trials of params can differ: the scenario only draws random
+// numbers for start jitter, short flows and random access link delays
+bool
+IsRandomized(const SimulationParameters& params)
+{
+    return params.startJitter.IsStrictlyPositive() || params.shortFlowLoad > 0 ||
+           params.senderDelay.rfind("ns3::", 0) == 0 ||
+           params.receiverDelay.rfind("ns3::", 0) == 0;
+}
+
+// Run trials 1, 2, ... of params until maxTrials, or, with ciTarget > 0, until
+// the 95% confidence interval of the goodput is within ciTarget (0.05 = 5%)
+// of its mean. Trials are run in batches of minTrials first, then of one per
+// worker, and the mean and confidence interval of every metric are written
+// to <dir>replication-<run name>.txt.
+int
+RunReplications(const SimulationParameters& params,
+                uint32_t maxTrials,
+                uint32_t minTrials,
+                double ciTarget,
+                uint32_t workers,
+                uint32_t retries)
+{
+    uint32_t batch = std::max(minTrials, 1u);
+    uint32_t trials = 0;
+    std::vector<TrialMetrics> metrics;
+    ConfidenceInterval goodput;
+    while (trials < maxTrials)
+    {
+        std::vector<SimulationParameters> rows;
+        for (uint32_t i = 0; i < batch && trials < maxTrials; ++i)
+        {
+            rows.push_back(params);
+            rows.back().trial = ++trials;
+        }
+        RunRows(rows, workers, retries, params.dir + "logs/");
+        for (const SimulationParameters& row : rows)
+        {
+            TrialMetrics trial;
+            // Failed trials are left out
+            if (ReadTrialMetrics(row, trial))
+            {
+                metrics.push_back(trial);
+            }
+        }
+
+        std::vector<double> goodputs;
+        for (const TrialMetrics& trial : metrics)
+        {
+            goodputs.push_back(trial.goodput);
+        }
+        goodput = EstimateMean(goodputs.begin(), goodputs.end());
+        std::cout << "Replication: " << trials << " trials, goodput " << goodput.mean << " +- "
+                  << goodput.halfWidth << " Mbps" << std::endl;
+        if (ciTarget > 0 && goodput.samples > 1 &&
+            goodput.halfWidth <= ciTarget * std::fabs(goodput.mean))
+        {
+            break;
+        }
+        batch = workers > 0 ? workers : GetAvailableCores();
+    }
+
+    std::string outputFile = params.dir + "replication-" + GetRunName(params) + ".txt";
+    std::ofstream out(outputFile);
+    out << "Trials: " << trials << " run, " << metrics.size() << " succeeded\n";
+    auto report = [&](const std::string& name, double TrialMetrics::*metric) {
+        std::vector<double> values;
+        for (const TrialMetrics& trial : metrics)
+        {
+            values.push_back(trial.*metric);
+        }
+        ConfidenceInterval ci = EstimateMean(values.begin(), values.end());
+        out << name << ": " << ci.mean << " +- " << ci.halfWidth << " (95% CI)\n";
+    };
+    report("Goodput (Mbps)", &TrialMetrics::goodput);
+    report("Retransmissions", &TrialMetrics::retransmissions);
+    report("Average Delay (s)", &TrialMetrics::delay);
+    report("Queue Time-average", &TrialMetrics::queue);
+    out.close();
+    std::cout << "Replication results written to " << outputFile << std::endl;
+    return metrics.size() == trials ? 0 : 1;
+}
+
+// Bytes of a full segment on the bottleneck link: TCP header with
+// timestamps, IPv4 and PPP headers
+uint32_t
+GetPacketSize(const SimulationParameters& params)
+{
+    return params.segmentSize + 32 + 20 + 2;
+}
+
+// The dumbbell of params as seen by the fluid model. Its queue is the FIFO
+// qdisc of the first bottleneck and the one packet device queue behind it.
+// Throws std::invalid_argument, like RunFluidModel(), for a dumbbell the
+// fluid model does not cover.
+FluidConfig
+GetFluidConfig(const SimulationParameters& params)
+{
+    if (params.qdiscTypeId != "ns3::FifoQueueDisc")
+    {
+        throw std::invalid_argument("The fluid model only has a FIFO queue, not " +
+                                    params.qdiscTypeId);
+    }
+    std::string senderDelay = params.senderDelay.empty() ? params.delay : params.senderDelay;
+    std::string receiverDelay = params.receiverDelay.empty() ? params.delay : params.receiverDelay;
+    if (senderDelay.rfind("ns3::", 0) == 0 || receiverDelay.rfind("ns3::", 0) == 0)
+    {
+        throw std::invalid_argument("The fluid model needs fixed access delays");
+    }
+
+    FluidConfig config;
+    DataRate rate(params.bottleneck_bandwidth);
+    config.bottleneckRate = rate.GetBitRate();
+    config.segmentSize = params.segmentSize;
+    config.packetSize = GetPacketSize(params);
+    Time oneWay = Time(senderDelay) + Time(params.delay) * int64_t(params.bottleneckHops);
+    if (params.receivers > 1)
+    {
+        oneWay += Time(receiverDelay);
+    }
+    Time serialization = rate.CalculateBytesTxTime(config.packetSize);
+    config.baseRtt = (oneWay * int64_t(2) + serialization * int64_t(params.bottleneckHops))
+                         .GetSeconds();
+    QueueSize queueSize(params.qdiscSize);
+    double queuePackets = queueSize.GetUnit() == QueueSizeUnit::BYTES
+                              ? static_cast<double>(queueSize.GetValue()) / config.packetSize
+                              : queueSize.GetValue();
+    config.queueLimit = (queuePackets + 1) * config.packetSize;
+    config.flows = params.numFlows * params.senders;
+    config.congestionControl = params.tcpTypeId.substr(5);
+    config.initialCwnd = 10;
+    config.start = 1;
+    config.stop = params.stopTime.GetSeconds();
+    return config;
+}
+
+// Bytes in the unit of the qdisc of params, like its Time-average in queueStats.txt
+double
+ToQueueUnit(const SimulationParameters& params, double bytes)
+{
+    bool packets = QueueSize(params.qdiscSize).GetUnit() == QueueSizeUnit::PACKETS;
+    return packets ? bytes / GetPacketSize(params) : bytes;
+}
+
+// Print the rows the fluid model skipped, with the reason of each
+void
+PrintSkippedRows(const std::vector<std::pair<std::string, std::string>>& skipped)
+{
+    if (skipped.empty())
+    {
+        return;
+    }
+    std::cout << "Skipped " << skipped.size() << " rows the fluid model does not cover:\n";
+    for (const auto& [run, reason] : skipped)
+    {
+        std::cout << "  " << run << ": " << reason << "\n";
+    }
+}
+
+// Estimate goodput, queue and losses of every row with the fluid model instead
+// of simulating packets, one line per row in outputFile. Rows the fluid model
+// does not cover (e.g. another qdisc) are skipped and listed at the end.
+int
+RunFluidRows(const std::vector<SimulationParameters>& rows, const std::string& outputFile)
+{
+    std::ofstream out(outputFile);
+    out << "qdiscSize,bottleneck_bandwidth,delay,tcpTypeId,numFlows,goodput_mbps,average_queue,"
+           "max_queue,lost_packets,loss_rate,wall_ms\n";
+    std::vector<std::pair<std::string, std::string>> skipped;
+    for (const SimulationParameters& row : rows)
+    {
+        auto start = std::chrono::steady_clock::now();
+        FluidResult result;
+        try
+        {
+            result = RunFluidModel(GetFluidConfig(row));
+        }
+        catch (const std::invalid_argument& e)
+        {
+            skipped.emplace_back(GetRunName(row), e.what());
+            continue;
+        }
+        double wallMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+        double lossRate = result.sentPackets > 0 ? result.lostPackets / result.sentPackets : 0;
+        out << row.qdiscSize << "," << row.bottleneck_bandwidth << "," << row.delay << ","
+            << row.tcpTypeId.substr(5) << "," << row.numFlows << "," << result.goodput << ","
+            << ToQueueUnit(row, result.averageQueue) << "," << ToQueueUnit(row, result.maxQueue)
+            << "," << result.lostPackets << "," << lossRate << "," << wallMs << "\n";
+        std::cout << GetRunName(row) << ": " << result.goodput << " Mbps, queue "
+                  << ToQueueUnit(row, result.averageQueue) << ", loss " << lossRate << " ("
+                  << wallMs << " ms)" << std::endl;
+    }
+    out.close();
+    PrintSkippedRows(skipped);
+    std::cout << "Fluid model results of " << rows.size() - skipped.size() << " rows written to "
+              << outputFile << std::endl;
+    return 0;
+}
+
+// Full-sized packets (GetPacketSize()) dropped by the bottleneck qdisc, from
+// queueStats.txt: its dropped bytes over the packet size, whatever the unit
+// of the qdisc, or the estimate for aggregated segments. This is the unit of
+// the lost packets of the fluid model.
+bool
+ReadQueueDrops(const SimulationParameters& params, double& drops)
+{
+    std::ifstream in(GetResultDir(params) + "queueStats.txt");
+    std::string line;
+    bool found = false;
+    while (std::getline(in, line))
+    {
+        // Packets/Bytes dropped: <packets> / <bytes>
+        std::size_t pos = line.find("Packets/Bytes dropped: ");
+        std::size_t slash = pos != std::string::npos ? line.find(" / ", pos) : pos;
+        if (slash != std::string::npos && !found)
+        {
+            drops = std::stod(line.substr(slash + 3)) / GetPacketSize(params);
+            found = true;
+        }
+        pos = line.find("Dropped segments (estimated): ");
+        if (pos != std::string::npos)
+        {
+            drops = std::stod(line.substr(pos + 30));
+            return true;
+        }
+    }
+    return found;
+}
+
+// Simulate samples rows spread evenly over csvFile packet by packet (cached
+// rows are not run again) and compare them with the fluid model. The rows go
+// to <dir>fluid-validation.csv with the goodput error relative to the
+// packet-level goodput, the queue error relative to the queue size and the
+// drops of both in full-sized packets. Rows the fluid model does not cover
+// are not sampled and are listed instead.
+int
+ValidateFluidModel(const std::string& csvFile,
+                   const SimulationParameters& defaults,
+                   uint32_t samples,
+                   uint32_t workers,
+                   uint32_t retries)
+{
+    std::vector<SimulationParameters> rows;
+    std::vector<std::pair<std::string, std::string>> skipped;
+    for (const SimulationParameters& row : ReadParameterRows(csvFile, defaults))
+    {
+        try
+        {
+            GetFluidConfig(row);
+            rows.push_back(row);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            skipped.emplace_back(GetRunName(row), e.what());
+        }
+    }
+    PrintSkippedRows(skipped);
+    NS_ABORT_MSG_UNLESS(!rows.empty(), "Sweep file " << csvFile << " has no rows to validate");
+    std::vector<SimulationParameters> sample;
+    uint32_t count = std::min<std::size_t>(std::max(samples, 1u), rows.size());
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sample.push_back(rows[i * rows.size() / count]);
+    }
+    RunRows(sample, workers, retries, defaults.dir + "logs/");
+
+    std::string outputFile = defaults.dir + "fluid-validation.csv";
+    std::ofstream out(outputFile);
+    out << "run,packet_goodput,fluid_goodput,goodput_error,packet_queue,fluid_queue,queue_error,"
+           "packet_drops,fluid_drops\n";
+    std::vector<double> goodputErrors;
+    std::vector<double> queueErrors;
+    for (const SimulationParameters& row : sample)
+    {
+        TrialMetrics packet;
+        double drops = 0;
+        if (!ReadTrialMetrics(row, packet) || !ReadQueueDrops(row, drops))
+        {
+            std::cout << GetRunName(row) << ": no packet-level results" << std::endl;
+            continue;
+        }
+        FluidConfig config = GetFluidConfig(row);
+        FluidResult fluid;
+        try
+        {
+            fluid = RunFluidModel(config);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cout << GetRunName(row) << ": skipped, " << e.what() << std::endl;
+            count--;
+            continue;
+        }
+        double fluidQueue = ToQueueUnit(row, fluid.averageQueue);
+        double goodputError =
+            packet.goodput > 0 ? (fluid.goodput - packet.goodput) / packet.goodput : 0;
+        double queueError = (fluidQueue - packet.queue) / ToQueueUnit(row, config.queueLimit);
+        goodputErrors.push_back(std::fabs(goodputError));
+        queueErrors.push_back(std::fabs(queueError));
+        out << GetRunName(row) << "," << packet.goodput << "," << fluid.goodput << ","
+            << goodputError << "," << packet.queue << "," << fluidQueue << "," << queueError
+            << "," << drops << "," << fluid.lostPackets << "\n";
+    }
+    out.close();
+
+    ConfidenceInterval goodput = EstimateMean(goodputErrors.begin(), goodputErrors.end());
+    ConfidenceInterval queue = EstimateMean(queueErrors.begin(), queueErrors.end());
+    std::cout << "Fluid model over " << goodput.samples << " rows: mean absolute goodput error "
+              << 100 * goodput.mean << "% +- " << 100 * goodput.halfWidth
+              << "%, queue error " << 100 * queue.mean << "% +- " << 100 * queue.halfWidth
+              << "% of the queue size; rows written to " << outputFile << std::endl;
+    return goodput.samples == count ? 0 : 1;
+}
+
+// Simulate every row both per packet and with segment aggregation, and write
+// how far the aggregated results are from the per-packet ones to outputFile:
+// goodput, retransmissions and drops (in segments) and queue (packet limits
+// counted in segments) as relative deviations, and the event and wall-clock
+// savings
+int
+CompareAggregation(const std::vector<SimulationParameters>& rows,
+                   uint32_t workers,
+                   uint32_t retries,
+                   const std::string& outputFile)
+{
+    std::vector<SimulationParameters> runs;
+    for (const SimulationParameters& row : rows)
+    {
+        runs.push_back(row);
+        runs.back().aggregation = 1;
+        runs.push_back(row);
+    }
+    RunRows(runs, workers, retries, rows.front().dir + "logs/");
+
+    auto deviation = [](double aggregated, double packet) {
+        return packet != 0 ? (aggregated - packet) / packet : 0;
+    };
+    std::ofstream out(outputFile);
+    out << "run,aggregation,goodput_dev,retransmissions_dev,drops_dev,queue_dev,delay_dev,"
+           "event_ratio,speedup\n";
+    uint32_t failed = 0;
+    for (std::size_t i = 0; i < runs.size(); i += 2)
+    {
+        const SimulationParameters& packet = runs[i];
+        const SimulationParameters& aggregated = runs[i + 1];
+        TrialMetrics packetMetrics;
+        TrialMetrics aggregatedMetrics;
+        double packetDrops = 0;
+        double aggregatedDrops = 0;
+        RunStats packetStats;
+        RunStats aggregatedStats;
+        if (!ReadTrialMetrics(packet, packetMetrics) ||
+            !ReadTrialMetrics(aggregated, aggregatedMetrics) ||
+            !ReadQueueDrops(packet, packetDrops) || !ReadQueueDrops(aggregated, aggregatedDrops) ||
+            !ReadRunStats(GetResultDir(packet) + "run-stats.txt", packetStats) ||
+            !ReadRunStats(GetResultDir(aggregated) + "run-stats.txt", aggregatedStats))
+        {
+            std::cout << GetRunName(packet) << ": missing results" << std::endl;
+            failed++;
+            continue;
+        }
+        uint32_t k = aggregated.aggregation;
+        bool packetLimit = QueueSize(packet.qdiscSize).GetUnit() == QueueSizeUnit::PACKETS;
+        double goodput = deviation(aggregatedMetrics.goodput, packetMetrics.goodput);
+        double eventRatio = aggregatedStats.events > 0
+                                ? static_cast<double>(packetStats.events) / aggregatedStats.events
+                                : 0;
+        double speedup = aggregatedStats.runWallSeconds > 0
+                             ? packetStats.runWallSeconds / aggregatedStats.runWallSeconds
+                             : 0;
+        out << GetRunName(packet) << "," << k << "," << goodput << ","
+            << deviation(aggregatedMetrics.retransmissions * k, packetMetrics.retransmissions)
+            << "," << deviation(aggregatedDrops, packetDrops) << ","
+            << deviation(aggregatedMetrics.queue * (packetLimit ? k : 1), packetMetrics.queue)
+            << "," << deviation(aggregatedMetrics.delay, packetMetrics.delay) << ","
+            << eventRatio << "," << speedup << "\n";
+        std::cout << GetRunName(packet) << " with " << k << " segments per packet: goodput "
+                  << 100 * goodput << "% off, " << eventRatio << "x fewer events, " << speedup
+                  << "x faster" << std::endl;
+    }
+    out.close();
+    std::cout << "Aggregation deviation written to " << outputFile << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// Adaptive version of --sweep. The rows of csvFile span the full grid of
+// buffer sizes, bandwidths and delays; both TcpCubic and TcpBbr rows (with
+// all their trials) are simulated on a coarse grid first, and points are then
+// added where the goodput gain of BBR over Cubic changes sign or is
+// uncertain across trials, until the cost of everything simulated reaches
+// budget times the cost of the full grid. The rows that were simulated are
+// written to <dir>/adaptive-parameters.csv in the schema of parameters.csv.
+int
+RunAdaptiveSweep(const std::string& csvFile,
+                 const SimulationParameters& defaults,
+                 double budget,
+                 uint32_t coarseStride,
+                 uint32_t workers,
+                 uint32_t retries)
+{
+    std::vector<SimulationParameters> rows = ReadParameterRows(csvFile, defaults);
+    NS_ABORT_MSG_UNLESS(!rows.empty(), "Sweep file " << csvFile << " has no rows");
+    std::vector<GridPoint> fullGrid;
+    std::set<uint32_t> trials;
+    double fullCost = 0;
+    for (const SimulationParameters& row : rows)
+    {
+        fullGrid.push_back({row.qdiscSize, row.bottleneck_bandwidth, row.delay});
+        trials.insert(row.trial);
+        fullCost += GetRunCost(row);
+    }
 
+    // Rows of one point: both variants with every trial; everything else is
+    // taken from the first row
+    auto rowsOf = [&](const GridPoint& point) {
+        std::vector<SimulationParameters> pointRows;
+        for (const char* tcp : {"ns3::TcpCubic", "ns3::TcpBbr"})
+        {
+            for (uint32_t trial : trials)
+            {
+                SimulationParameters row = rows.front();
+                row.qdiscSize = point.qdiscSize;
+                row.bottleneck_bandwidth = point.bandwidth;
+                row.delay = point.delay;
+                row.tcpTypeId = tcp;
+                row.trial = trial;
+                pointRows.push_back(row);
+            }
+        }
+        return pointRows;
+    };
+    auto costOf = [&](const std::vector<GridPoint>& points) {
+        double cost = 0;
+        for (const GridPoint& point : points)
+        {
+            for (const SimulationParameters& row : rowsOf(point))
+            {
+                cost += GetRunCost(row);
+            }
+        }
+        return cost;
+    };
+
+    // Points closer than a factor 1.1 are not split any further; a gain is
+    // uncertain if its confidence interval includes 0
+    AdaptiveGrid grid(fullGrid, coarseStride, 1.1, 1.0);
+    std::vector<GridPoint> points = grid.GetCoarsePoints();
+    double spent = 0;
+    std::vector<SimulationParameters> simulated;
+    for (uint32_t round = 1; !points.empty(); ++round)
+    {
+        spent += costOf(points);
+        std::vector<SimulationParameters> roundRows;
+        for (const GridPoint& point : points)
+        {
+            std::vector<SimulationParameters> pointRows = rowsOf(point);
+            roundRows.insert(roundRows.end(), pointRows.begin(), pointRows.end());
+        }
+        std::cout << "Adaptive sweep round " << round << ": " << points.size() << " points, "
+                  << roundRows.size() << " rows, " << 100 * spent / fullCost
+                  << "% of the full grid cost" << std::endl;
+        RunRows(roundRows, workers, retries, defaults.dir + "logs/");
+        simulated.insert(simulated.end(), roundRows.begin(), roundRows.end());
+
+        for (const GridPoint& point : points)
+        {
+            std::vector<double> gains;
+            for (uint32_t trial : trials)
+            {
+                double cubic;
+                double bbr;
+                SimulationParameters row = rowsOf(point).front();
+                row.trial = trial;
+                row.tcpTypeId = "ns3::TcpCubic";
+                bool found = ReadGoodput(row, cubic);
+                row.tcpTypeId = "ns3::TcpBbr";
+                if (found && ReadGoodput(row, bbr))
+                {
+                    gains.push_back(bbr - cubic);
+                }
+            }
+            // Points whose runs failed are left out of the refinement; with a
+            // single trial the gain counts as uncertain
+            if (!gains.empty())
+            {
+                ConfidenceInterval gain = EstimateMean(gains.begin(), gains.end());
+                grid.SetGain(point, gain.mean, gain.halfWidth, gain.samples);
+            }
+        }
+
+        double remaining = budget * fullCost - spent;
+        points = grid.Refine([&](const std::vector<GridPoint>& cellPoints) {
+            double cost = costOf(cellPoints);
+            if (cost > remaining)
+            {
+                return false;
+            }
+            remaining -= cost;
+            return true;
+        });
+    }
+
+    std::string outputFile = defaults.dir + "adaptive-parameters.csv";
+    std::ofstream out(outputFile);
+    out << "qdiscSize,bottleneck_bandwidth,delay,tcpTypeId,trial\n";
+    for (const SimulationParameters& row : simulated)
+    {
+        out << row.qdiscSize << "," << row.bottleneck_bandwidth << "," << row.delay << ","
+            << row.tcpTypeId.substr(5) << "," << row.trial << "\n";
+    }
+    std::cout << "Simulated " << simulated.size() << " of " << rows.size() << " rows at "
+              << 100 * spent / fullCost << "% of the full grid cost; grid written to "
+              << outputFile << std::endl;
     return 0;
 }
+
+// Run the heaviest rows of csvFile (by GetRunCost()) under every scheduler of
+// the comma-separated list schedulers, one run at a time and never from the
+// cache, and write the event loop time of each to
+// <dir>/scheduler-comparison.csv, with its speedup over the first scheduler.
+// The event count and flow results of every run are checked against those of
+// the first scheduler, and any difference fails the comparison. The runs of
+// a scheduler go to <dir>/schedulers/<scheduler>/.
+int
+CompareSchedulers(const std::string& csvFile,
+                  const SimulationParameters& defaults,
+                  const std::string& schedulers,
+                  uint32_t heaviest,
+                  uint32_t retries)
+{
+    std::vector<SimulationParameters> rows = ReadParameterRows(csvFile, defaults);
+    std::stable_sort(rows.begin(),
+                     rows.end(),
+                     [](const SimulationParameters& a, const SimulationParameters& b) {
+                         return GetRunCost(a) > GetRunCost(b);
+                     });
+    rows.resize(std::min<std::size_t>(rows.size(), heaviest));
+
+    std::vector<std::string> names;
+    std::stringstream ss(schedulers);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        TypeId tid;
+        NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(GetSchedulerTypeId(name), &tid),
+                            "Unknown scheduler " << name);
+        names.push_back(name);
+    }
+    NS_ABORT_MSG_UNLESS(!names.empty(), "No scheduler to compare");
+
+    std::vector<SimulationParameters> cases;
+    std::vector<SweepJob> jobs;
+    for (const SimulationParameters& row : rows)
+    {
+        for (const std::string& scheduler : names)
+        {
+            SimulationParameters c = row;
+            c.scheduler = scheduler;
+            c.useCache = false;
+            c.dir = defaults.dir + "schedulers/" + scheduler + "/";
+            // logs/ has no subdirectory per scheduler
+            jobs.push_back({cases.size(), 0, scheduler + "." + GetJobName(c)});
+            cases.push_back(c);
+        }
+    }
+    // One run at a time, so that they do not compete for memory bandwidth
+    RunSweepInParallel(
+        jobs,
+        [&cases](std::size_t i) { return RunJob(cases[i]); },
+        1,
+        retries,
+        defaults.dir + "logs/");
+
+    // Every scheduler must execute the same events in the same order, so the
+    // runs of a row must have the same event count and flow results
+    auto sameResults = [](const std::vector<FlowResult>& a, const std::vector<FlowResult>& b) {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (std::size_t k = 0; k < a.size(); ++k)
+        {
+            if (a[k].source != b[k].source || a[k].throughput != b[k].throughput ||
+                a[k].retransmissions != b[k].retransmissions || a[k].delay != b[k].delay ||
+                a[k].rxPackets != b[k].rxPackets)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::string outputFile = defaults.dir + "scheduler-comparison.csv";
+    std::ofstream out(outputFile);
+    out << "run,scheduler,run_wall_s,events,events_per_s,speedup,identical\n";
+    uint32_t failed = 0;
+    uint32_t different = 0;
+    for (std::size_t i = 0; i < cases.size(); i += names.size())
+    {
+        double reference = 0;
+        uint64_t referenceEvents = 0;
+        std::vector<FlowResult> referenceFlows;
+        for (std::size_t j = 0; j < names.size(); ++j)
+        {
+            const SimulationParameters& c = cases[i + j];
+            RunStats stats;
+            if (!ReadRunStats(GetResultDir(c) + "run-stats.txt", stats))
+            {
+                failed++;
+                continue;
+            }
+            std::vector<FlowResult> flows = ReadFlowResults(c);
+            // The first scheduler whose run succeeded is the reference
+            if (referenceEvents == 0)
+            {
+                reference = stats.runWallSeconds;
+                referenceEvents = stats.events;
+                referenceFlows = flows;
+            }
+            double speedup = reference > 0 && stats.runWallSeconds > 0
+                                 ? reference / stats.runWallSeconds
+                                 : 0;
+            bool identical = stats.events == referenceEvents && sameResults(flows, referenceFlows);
+            different += identical ? 0 : 1;
+            out << GetRunName(c) << "," << c.scheduler << "," << stats.runWallSeconds << ","
+                << stats.events << "," << stats.events / std::max(stats.runWallSeconds, 1e-9)
+                << "," << speedup << "," << identical << "\n";
+            std::cout << GetRunName(c) << " " << c.scheduler << ": " << stats.runWallSeconds
+                      << " s, " << stats.events << " events, " << speedup << "x"
+                      << (identical ? "" : ", results differ from " + names.front())
+                      << std::endl;
+        }
+    }
+    out.close();
+    std::cout << "Scheduler comparison written to " << outputFile << std::endl;
+    if (different > 0)
+    {
+        std::cout << different << " runs differ from the results of " << names.front()
+                  << std::endl;
+    }
+    return failed == 0 && different == 0 ? 0 : 1;
+}
+
+int
+main(int argc, char* argv[])
+{
+    // uint32_t num_streams = 1;
+    SimulationParameters params;
+    // The heartbeat in status/ reports progress; INFO logs only on request
+    bool enableLogs = false;
+    // std::string recovery = "ns3::TcpClassicRecovery";
+    std::string errorModelType = "ns3::RateErrorModel";
+    std::string sweepFile = "";
+    uint32_t workers = 1;
+    uint32_t retries = 1;
+    uint32_t trials = 0;
+    uint32_t minTrials = 3;
+    uint32_t trialWorkers = 0;
+    double ciTarget = 0;
+    std::string adaptiveFile = "";
+    double budget = 0.5;
+    uint32_t coarseStride = 2;
+    std::string benchmarkFile = "";
+    std::string baselineFile = "";
+    double regressionThreshold = 0.1;
+    std::string compareFile = "";
+    std::string schedulers = "map,heap,list,calendar,priority,bucket";
+    uint32_t heaviest = 3;
+    std::string engine = "packet";
+    std::string fluidValidationFile = "";
+    uint32_t fluidSamples = 10;
+    bool compareAggregation = false;
+
+    CommandLine cmd;
+    cmd.AddValue("tcpTypeId",
+                 "TCP variant to use (e.g., ns3::TcpNewReno, ns3::TcpLinuxReno, etc.)",
+                 params.tcpTypeId);
+    cmd.AddValue("qdiscTypeId", "Queue disc for gateway (e.g., ns3::CoDelQueueDisc, ns3::FifoQueueDisc)", params.qdiscTypeId);
+    cmd.AddValue("segmentSize", "TCP segment size (bytes)", params.segmentSize);
+    cmd.AddValue("delAckCount", "Delayed ack count", params.delAckCount);
+    cmd.AddValue("enableSack", "Flag to enable/disable sack in TCP", params.isSack);
+    cmd.AddValue("stopTime",
+                 "Stop time for applications / simulation time will be stopTime",
+                 params.stopTime);
+    // cmd.AddValue("recovery", "Recovery algorithm type to use (e.g., ns3::TcpPrrRecovery", recovery);
+    cmd.AddValue("qdiscSize", "Size of the queue", params.qdiscSize);
+    cmd.AddValue("delay", "Delay of the link", params.delay);
+    cmd.AddValue("bottleneck_bandwidth", "Bandwidth of the bottleneck link", params.bottleneck_bandwidth);
+    cmd.AddValue("dir", "Directory to store the results", params.dir);
+    cmd.AddValue("queueSampleInterval",
+                 "Interval of the samples written to queue-size.dat (0 disables the file)",
+                 params.queueSampleInterval);
+    cmd.AddValue("traceFormat",
+                 "Format of queue-size and drop traces: text (.dat) or binary (.bin, "
+                 "read with tcp-scenario-common/bintrace.py)",
+                 params.traceFormat);
+    cmd.AddValue("asyncTraces", "Write trace files from a background thread", params.asyncTraces);
+    cmd.AddValue("profile",
+                 "Write profile.txt with event counts, event rate and wall time per event "
+                 "type and node",
+                 params.profile);
+    cmd.AddValue("scheduler",
+                 "Event scheduler: map (ns-3 default), heap, list, calendar, priority or bucket "
+                 "(BucketCalendarScheduler, sized to the bottleneck); does not change the results",
+                 params.scheduler);
+    cmd.AddValue("convergenceTolerance",
+                 "End a run early once the 95% confidence half-width of the goodput is below "
+                 "this fraction of its mean (0 = always run until stopTime)",
+                 params.convergenceTolerance);
+    cmd.AddValue("convergenceQueueTolerance",
+                 "Also require the queue occupancy to settle to this relative half-width "
+                 "(0 = goodput only)",
+                 params.convergenceQueueTolerance);
+    cmd.AddValue("convergenceWindow",
+                 "Length of the windows in which goodput and queue are averaged",
+                 params.convergenceWindow);
+    cmd.AddValue("convergenceBatches",
+                 "Number of most recent windows the confidence interval is computed over",
+                 params.convergenceBatches);
+    cmd.AddValue("convergenceMinTime",
+                 "Minimum simulated time before a run may be ended early",
+                 params.convergenceMinTime);
+    cmd.AddValue("numFlows", "Number of concurrent BulkSend flows", params.numFlows);
+    cmd.AddValue("flowStagger", "Time between the starts of consecutive flows", params.flowStagger);
+    cmd.AddValue("startJitter",
+                 "Random extra delay of up to this much for the start of every flow",
+                 params.startJitter);
+    cmd.AddValue("traceCwnd",
+                 "Write cwndTraces/cwnd-<port> and ssthresh-<port> for every flow, in "
+                 "segments of --segmentSize (not super-segments with --aggregation)",
+                 params.traceCwnd);
+    cmd.AddValue("pcap", "Write a pcap of every point-to-point device to pcap/", params.pcap);
+    cmd.AddValue("snapLength",
+                 "Bytes of every packet kept in the pcaps (96 keeps the headers only)",
+                 params.pcapCapture.snapLength);
+    cmd.AddValue("pcapSampleEvery",
+                 "Keep one in this many packets of a device in the pcaps",
+                 params.pcapCapture.sampleEvery);
+    cmd.AddValue("pcapDuration",
+                 "Capture only this long from the start (0 = whole run)",
+                 params.pcapCapture.captureFor);
+    cmd.AddValue("pcapRotateBytes",
+                 "Start a new pcap file after this many bytes (0 = never)",
+                 params.pcapCapture.rotateBytes);
+    cmd.AddValue("pcapRotateInterval",
+                 "Start a new pcap file after this much simulated time (0 = never)",
+                 params.pcapCapture.rotateInterval);
+    cmd.AddValue("pcapCompression",
+                 "Compression of the pcaps: none, gzip (.pcap.gz) or zstd (.pcap.zst)",
+                 params.pcapCapture.compression);
+    cmd.AddValue("traceBbr",
+                 "Also write the BBR state (0 Startup, 1 Drain, 2 ProbeBW, 3 ProbeRTT), BtlBw, "
+                 "min RTT and pacing rate of every TcpBbr flow to cwndTraces/, and the time "
+                 "per state and ProbeRTT episodes to bbrStats.txt",
+                 params.traceBbr);
+    cmd.AddValue("cwndSampleInterval",
+                 "Minimum time between two samples of a flow's cwnd traces (0 = every change)",
+                 params.cwndSampleInterval);
+    cmd.AddValue("goodputBin",
+                 "Bin width of the goodput time series in goodput.dat",
+                 params.goodputBin);
+    cmd.AddValue("warmup",
+                 "Time after the start of the flows excluded from the steady goodput",
+                 params.warmup);
+    cmd.AddValue("histogramBinWidth",
+                 "Bin width of the FlowMonitor delay and jitter histograms behind the "
+                 "percentiles and delayHistograms.txt",
+                 params.histogramBinWidth);
+    cmd.AddValue("flowAccounting",
+                 "Per-flow results from FlowMonitor on all nodes (flowmonitor), from the TCP "
+                 "endpoints only (endpoint), or both, with the endpoint results in "
+                 "endpoint_results.txt",
+                 params.flowAccounting);
+    cmd.AddValue("senders", "Number of sender nodes, each running numFlows flows", params.senders);
+    cmd.AddValue("receivers", "Number of receiver nodes", params.receivers);
+    cmd.AddValue("bottleneckHops",
+                 "Number of bottleneck links in a row (> 1 for a parking lot)",
+                 params.bottleneckHops);
+    cmd.AddValue("senderDelay",
+                 "Delay of each sender access link: a time or a random variable in ms, e.g. "
+                 "ns3::UniformRandomVariable[Min=1|Max=20] (default: delay)",
+                 params.senderDelay);
+    cmd.AddValue("receiverDelay",
+                 "Delay of each receiver access link when receivers > 1, like senderDelay",
+                 params.receiverDelay);
+    cmd.AddValue("bufferBdp",
+                 "Size the TCP send and receive buffers to this many bandwidth-delay products "
+                 "of the longest path (e.g. 2 leaves room for a queue of one BDP; 0 = 1 GB)",
+                 params.bufferBdp);
+    cmd.AddValue("reportBuffers",
+                 "Report the high-water marks of the TCP send and receive buffers (always "
+                 "with --bufferBdp)",
+                 params.reportBuffers);
+    cmd.AddValue("aggregation",
+                 "Segments carried by one TCP packet, with the MTU and packet queue limits "
+                 "scaled to match (1 = per packet); results go to aggregation-<k>/",
+                 params.aggregation);
+    cmd.AddValue("shortFlowLoad",
+                 "Add short flows with Poisson arrivals at this fraction of the bottleneck rate "
+                 "(0 = none) and report their completion times by size; per flow in "
+                 "flowCompletionTimes.txt",
+                 params.shortFlowLoad);
+    cmd.AddValue("flowSizeCdf",
+                 "File of \"bytes probability\" lines with the short flow size distribution "
+                 "(default: the DCTCP web search workload)",
+                 params.flowSizeCdf);
+    cmd.AddValue("shortFlowConnections",
+                 "Persistent connections of every sender over which the short flows are sent "
+                 "one after another; flows wait while all of them are busy",
+                 params.shortFlowConnections);
+    cmd.AddValue("shortFlowSlowStart",
+                 "Start every short flow from the initial window, as on a new connection, "
+                 "instead of the window its connection was left with",
+                 params.shortFlowSlowStart);
+    cmd.AddValue("compareAggregation",
+                 "Simulate the run (or every --sweep row) per packet and with --aggregation and "
+                 "write the deviation of the aggregated results to "
+                 "<dir>/aggregation-deviation.csv",
+                 compareAggregation);
+    cmd.AddValue("cache",
+                 "Reuse the results of an earlier run with identical parameters, RNG run "
+                 "and build instead of simulating again",
+                 params.useCache);
+    cmd.AddValue("heartbeat",
+                 "Wall-clock seconds between two updates of status/<run>.txt with the simulated "
+                 "time, speed, events, ETA and RSS of the run (0 = no status file)",
+                 params.heartbeat);
+    cmd.AddValue("maxWallTime",
+                 "Stop a run after this many wall-clock seconds and keep its partial results "
+                 "in partial/ (0 = no limit)",
+                 params.maxWallTime);
+    cmd.AddValue("maxRss",
+                 "Stop a run once the process uses more than this many MB of resident memory "
+                 "and keep its partial results in partial/ (0 = no limit)",
+                 params.maxRss);
+    cmd.AddValue("enableLogs",
+                 "INFO logging of BulkSendApplication, PacketSink and TcpL4Protocol (off by "
+                 "default; see --heartbeat for progress)",
+                 enableLogs);
+    cmd.AddValue("sweep",
+                 "CSV file (e.g., parameters.csv) whose rows are all simulated in this process; "
+                 "the other options act as defaults for columns missing from the file",
+                 sweepFile);
+    cmd.AddValue("workers",
+                 "Worker processes used by --sweep (0 = one per core, 1 = run rows one after "
+                 "another in this process)",
+                 workers);
+    cmd.AddValue("retries", "How often a sweep row is retried after its worker crashed", retries);
+    cmd.AddValue("adaptive",
+                 "CSV file of a full grid (e.g., parameters.csv) to sweep adaptively: a coarse "
+                 "grid first, then points where the goodput gain of TcpBbr over TcpCubic "
+                 "changes sign or is uncertain",
+                 adaptiveFile);
+    cmd.AddValue("budget",
+                 "Cost of an --adaptive sweep as a fraction of the cost of the full grid",
+                 budget);
+    cmd.AddValue("coarseStride",
+                 "Every how many bandwidths and delays of the full grid the coarse grid of "
+                 "--adaptive takes",
+                 coarseStride);
+    cmd.AddValue("trials",
+                 "Replicate the run up to this many trials, each with its own RNG run number, "
+                 "and write the mean and confidence interval of the results to "
+                 "<dir>replication-<run name>.txt (use with --startJitter)",
+                 trials);
+    cmd.AddValue("minTrials", "Trials run before --ciTarget is checked", minTrials);
+    cmd.AddValue("trialWorkers",
+                 "Worker processes used by --trials (0 = one per available core)",
+                 trialWorkers);
+    cmd.AddValue("ciTarget",
+                 "Stop adding --trials once the 95% confidence interval of the goodput is "
+                 "within this fraction of its mean (0 = run all trials)",
+                 ciTarget);
+    cmd.AddValue("benchmark",
+                 "CSV file of benchmark cases (e.g., benchmark.csv); each is run alone in a fresh "
+                 "process and the costs are written to <dir>/benchmark-results.csv",
+                 benchmarkFile);
+    cmd.AddValue("baseline",
+                 "benchmark-results.csv of an earlier --benchmark run to compare with",
+                 baselineFile);
+    cmd.AddValue("regressionThreshold",
+                 "Relative change for the worse (0.1 = 10%) flagged as a regression by --baseline",
+                 regressionThreshold);
+    cmd.AddValue("compareSchedulers",
+                 "CSV file of a sweep (e.g., parameters.csv) whose heaviest rows are run under "
+                 "every scheduler of --schedulers; the event loop times are written to "
+                 "<dir>/scheduler-comparison.csv, and runs whose results differ between "
+                 "schedulers fail it",
+                 compareFile);
+    cmd.AddValue("schedulers",
+                 "Comma-separated schedulers compared by --compareSchedulers; speedups are "
+                 "relative to the first",
+                 schedulers);
+    cmd.AddValue("heaviest", "Number of rows compared by --compareSchedulers", heaviest);
+    cmd.AddValue("engine",
+                 "packet: simulate every packet; fluid: estimate goodput, queue and loss of the "
+                 "run or of every --sweep row with the fluid model in milliseconds, written to "
+                 "<dir>/fluid-results.csv",
+                 engine);
+    cmd.AddValue("validateFluid",
+                 "CSV file of a sweep (e.g., parameters.csv) from which --fluidSamples rows are "
+                 "simulated with both engines; the errors are written to "
+                 "<dir>/fluid-validation.csv",
+                 fluidValidationFile);
+    cmd.AddValue("fluidSamples", "Number of rows compared by --validateFluid", fluidSamples);
+    cmd.Parse(argc, argv);
+    baseRngRun = RngSeedManager::GetRun();
+
+    NS_ABORT_MSG_UNLESS(params.traceFormat == "text" || params.traceFormat == "binary",
+                        "Unknown trace format " << params.traceFormat);
+    NS_ABORT_MSG_UNLESS(params.flowAccounting == "flowmonitor" ||
+                            params.flowAccounting == "endpoint" ||
+                            params.flowAccounting == "both",
+                        "Unknown flow accounting " << params.flowAccounting);
+    TypeId schedulerTid;
+    NS_ABORT_MSG_UNLESS(
+        TypeId::LookupByNameFailSafe(GetSchedulerTypeId(params.scheduler), &schedulerTid),
+        "Unknown scheduler " << params.scheduler);
+    NS_ABORT_MSG_UNLESS(IsValidAggregation(params),
+                        "aggregation must be at least 1 and fit a super-segment in 64 KB");
+    NS_ABORT_MSG_UNLESS(params.bufferBdp >= 0, "bufferBdp must not be negative");
+    NS_ABORT_MSG_UNLESS(params.shortFlowLoad >= 0 && params.shortFlowLoad < 1,
+                        "shortFlowLoad must be in [0, 1)");
+    NS_ABORT_MSG_UNLESS(params.shortFlowConnections > 0, "shortFlowConnections must be positive");
+    NS_ABORT_MSG_UNLESS(params.goodputBin.IsStrictlyPositive(),
+                        "goodputBin must be positive");
+    NS_ABORT_MSG_UNLESS(params.histogramBinWidth.IsStrictlyPositive(),
+                        "histogramBinWidth must be positive");
+
+    if (enableLogs)
+    {
+        LogComponentEnable("BulkSendApplication", LOG_LEVEL_INFO);
+        LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
+        LogComponentEnable("TcpL4Protocol", LOG_LEVEL_INFO);
+    }
+
+    // --dir="output_${qdiscSize}_${bottleneck_bandwidth}_${delay}_${tcpTypeId}_${trial}" 
+    if (!benchmarkFile.empty())
+    {
+        std::vector<SimulationParameters> cases = ReadParameterRows(benchmarkFile, params);
+        std::vector<SweepJob> jobs;
+        for (std::size_t i = 0; i < cases.size(); ++i)
+        {
+            // Every case is measured, never taken from the cache
+            cases[i].useCache = false;
+            jobs.push_back({i, 0, GetRunName(cases[i])});
+        }
+        // One case at a time, so that they do not compete for memory bandwidth
+        RunSweepInParallel(
+            jobs,
+            [&cases](std::size_t row) { return RunJob(cases[row]); },
+            1,
+            0,
+            params.dir + "logs/");
+
+        BenchmarkResults results;
+        for (const SimulationParameters& c : cases)
+        {
+            RunStats stats;
+            if (ReadRunStats(GetResultDir(c) + "run-stats.txt", stats))
+            {
+                results[GetRunName(c)] = stats;
+            }
+        }
+        WriteBenchmarkResults(params.dir + "benchmark-results.csv", results);
+        std::cout << "Benchmark results written to " << params.dir << "benchmark-results.csv"
+                  << std::endl;
+        if (baselineFile.empty())
+        {
+            return results.size() == cases.size() ? 0 : 1;
+        }
+        uint32_t regressions =
+            CompareWithBaseline(ReadBenchmarkResults(baselineFile), results, regressionThreshold);
+        return regressions == 0 && results.size() == cases.size() ? 0 : 1;
+    }
+
+    NS_ABORT_MSG_UNLESS(engine == "packet" || engine == "fluid", "Unknown engine " << engine);
+    if (engine == "fluid")
+    {
+        SystemPath::MakeDirectories(params.dir);
+        std::vector<SimulationParameters> rows =
+            sweepFile.empty() ? std::vector<SimulationParameters>{params}
+                              : ReadParameterRows(sweepFile, params);
+        return RunFluidRows(rows, params.dir + "fluid-results.csv");
+    }
+
+    if (compareAggregation)
+    {
+        NS_ABORT_MSG_UNLESS(params.aggregation > 1, "--compareAggregation needs --aggregation > 1");
+        SystemPath::MakeDirectories(params.dir);
+        std::vector<SimulationParameters> rows =
+            sweepFile.empty() ? std::vector<SimulationParameters>{params}
+                              : ReadParameterRows(sweepFile, params);
+        return CompareAggregation(rows, workers, retries, params.dir + "aggregation-deviation.csv");
+    }
+
+    if (!fluidValidationFile.empty())
+    {
+        return ValidateFluidModel(fluidValidationFile, params, fluidSamples, workers, retries);
+    }
+
+    if (!compareFile.empty())
+    {
+        return CompareSchedulers(compareFile, params, schedulers, heaviest, retries);
+    }
+
+    if (trials > 0)
+    {
+        // Identical trials would report a confidence interval of 0
+        NS_ABORT_MSG_UNLESS(trials == 1 || IsRandomized(params),
+                            "--trials > 1 needs --startJitter, --shortFlowLoad or a random "
+                            "--senderDelay/--receiverDelay, or every trial gives the same "
+                            "results");
+        return RunReplications(params,
+                               trials,
+                               minTrials,
+                               ciTarget,
+                               trialWorkers > 0 ? trialWorkers : GetAvailableCores(),
+                               retries);
+    }
+
+    if (!adaptiveFile.empty())
+    {
+        return RunAdaptiveSweep(adaptiveFile, params, budget, coarseStride, workers, retries);
+    }
+
+    if (sweepFile.empty())
+    {
+        return RunJob(params);
+    }
+
+    std::vector<SimulationParameters> rows = ReadParameterRows(sweepFile, params);
+    return RunRows(rows, workers, retries, params.dir + "logs/") == 0 ? 0 : 1;
+}
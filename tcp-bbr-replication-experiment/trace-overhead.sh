@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# Cost of the tracers: runs the benchmark cells in benchmark.csv with a build
+# where every tracer is NoTrace, then with the default build (ConfiguredTracers
+# with all tracers), and prints the difference of every case and metric. The
+# default build is left configured at the end.
+ROOT_DIR=`pwd`
+CSV_FILE="${ROOT_DIR}/benchmark.csv"
+NS3_DIR="/home/ubuntu/source/ns-3.42/"
+PATH=$PATH:"${NS3_DIR}"
+OUTPUT_DIR="${ROOT_DIR}/trace-overhead/"
+NO_TRACE_FLAGS="-DTCP_SCENARIO_TRACE_QUEUE=0 -DTCP_SCENARIO_TRACE_DROP=0 -DTCP_SCENARIO_TRACE_CWND=0 -DTCP_SCENARIO_TRACE_PCAP=0 -DTCP_SCENARIO_FLOW_STATS=0"
+# The traced build is expected to be slower; only report, never fail
+THRESHOLD=1000
+
+run_benchmark() {
+	COMMAND="ns3 run \"tcp-bbr-replication.cc --benchmark=${CSV_FILE} --dir=$1 --regressionThreshold=${THRESHOLD}$2\""
+	echo "Running: $COMMAND"
+	eval $COMMAND
+}
+
+ns3 configure -- -DCMAKE_CXX_FLAGS="${NO_TRACE_FLAGS}" && ns3 build || exit 1
+run_benchmark "${OUTPUT_DIR}no-trace/" ""
+
+ns3 configure -- -DCMAKE_CXX_FLAGS="" && ns3 build || exit 1
+# The comparison printed here is the overhead of the tracers
+run_benchmark "${OUTPUT_DIR}traced/" " --baseline=${OUTPUT_DIR}no-trace/benchmark-results.csv"
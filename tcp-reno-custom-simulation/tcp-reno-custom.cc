@@ -24,12 +24,17 @@
 //             1 ms         10 ms          
 // - TCP flow from n0 to n3 using BulkSendApplication.
 // - The following simulation output is stored in results/ in ns-3 top-level directory:
-//   - cwnd traces are stored in cwndTraces folder
+//   - cwnd and ssthresh traces are stored in cwndTraces folder (n0.dat,
+//     ssthresh.dat)
 //   - queue length statistics are stored in queue-size.dat file
-//   - pcaps are stored in pcap folder
+//   - pcaps are stored in pcap folder (ns-3-<node>-<device>.pcap), see the
+//     snapLength and pcap* options for truncation, sampling, rotation and
+//     compression
 //   - queueTraces folder contain the drop statistics at queue
 //   - queueStats.txt file contains the queue stats and config.txt file contains
 //     the simulation configuration.
+// - Each of these traces can be left out of the build, see
+//   tcp-scenario-common/trace-policies.h.
 // - The cwnd and queue length traces obtained from this example were tested against
 //   the respective traces obtained from Linux Reno by using ns-3 Direct Code Execution.
 //   See internet/doc/tcp.rst for more details.
@@ -47,10 +52,16 @@
 #include "ns3/flow-monitor-helper.h"
 #include "ns3/flow-monitor-module.h" 
 
+#include "../tcp-scenario-common/async-trace-writer.h"
+#include "../tcp-scenario-common/bucket-scheduler.h"
+#include "../tcp-scenario-common/scenario-apps.h"
+#include "../tcp-scenario-common/trace-policies.h"
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <sys/stat.h>
 
 using namespace ns3;
@@ -58,132 +69,6 @@ std::string dir = "results/";
 Time stopTime = Seconds(60);
 uint32_t segmentSize = 1448;
 
-std::ofstream fPlotSsthresh;
-std::ofstream fPlotQueue;
-std::ofstream fPlotCwnd;
-
-// Function to check queue length of Router 1
-void
-CheckQueueSize(Ptr<QueueDisc> queue)
-{
-    uint32_t qSize = queue->GetCurrentSize().GetValue();
-
-    // Check queue size every 1/100 of a second
-    Simulator::Schedule(Seconds(0.001), &CheckQueueSize, queue);
-    fPlotQueue << Simulator::Now().GetSeconds() << " " << qSize << std::endl;
-}
-
-// Function to trace change in cwnd at n0
-// Function to calculate drops in a particular Queue
-static void
-DropAtQueue(Ptr<OutputStreamWrapper> stream, Ptr<const QueueDiscItem> item)
-{
-    *stream->GetStream() << Simulator::Now().GetSeconds() << " 1" << std::endl;
-}
-static void
-CwndChange(uint16_t port, uint32_t oldCwnd, uint32_t newCwnd)
-{
-    //convert cwnd from bytes to number of segments
-    fPlotCwnd << Simulator::Now().GetSeconds() << " " << newCwnd / segmentSize <<" "<<port<< std::endl;
-}
-
-static void SsthreshChange(uint16_t port, uint32_t oldSsthresh, uint32_t newSsthresh)
-{
-    fPlotSsthresh << Simulator::Now().GetSeconds() << " " << newSsthresh / segmentSize << " "<< port<< std::endl;
-}
-
-
-// Trace Function for cwnd
-void
-TraceCwnd(uint32_t node, uint32_t cwndWindow, uint16_t port)
-{
-    Config::ConnectWithoutContext("/NodeList/" + std::to_string(node) +
-                                      "/$ns3::TcpL4Protocol/SocketList/" +
-                                      std::to_string(cwndWindow) + "/CongestionWindow",
-                                    MakeBoundCallback(&CwndChange, port)
-                                  );
-}
-
-// Trace Function for ssthresh
-void TraceSsthresh(uint32_t node, uint32_t cwndWindow, uint16_t port)
-{    
-    Config::ConnectWithoutContext("/NodeList/" + std::to_string(node) +
-                                  "/$ns3::TcpL4Protocol/SocketList/" +
-                                  std::to_string(cwndWindow) + "/SlowStartThreshold",
-                                    MakeBoundCallback(&SsthreshChange, port)
-                                  );
-}
-
-//Sender side
-// Function to install BulkSend application
-void InstallBulkSend(Ptr<Node> node, Ipv4Address address, uint16_t port,
-                     std::string socketFactory, uint32_t nodeId, uint32_t cwndWindow,
-                     uint16_t num_flows = 1)
-{
-    for (uint16_t i = 0; i < num_flows; ++i)
-    {
-        BulkSendHelper source(socketFactory, InetSocketAddress(address, port + i));
-        source.SetAttribute("MaxBytes", UintegerValue(0));
-        ApplicationContainer sourceApps = source.Install(node);
-        sourceApps.Start(Seconds(1.0 + i * 0.1)); // Stagger the start times slightly
-        Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceCwnd, nodeId, cwndWindow, port + i);
-        Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceSsthresh, nodeId, cwndWindow, port + i);
-        sourceApps.Stop(stopTime+Seconds(i * 0.1)); // Ensure stopTime is set appropriately and staggered
-    }
-}
-void InstallOnOff(Ptr<Node> node, Ipv4Address address, uint16_t port,
-                  std::string socketFactory, uint32_t nodeId, uint32_t cwndWindow,
-                  DataRate dataRate, uint16_t num_flows = 1, double stopTime = 100.0)
-{
-    for (uint16_t i = 0; i < num_flows; ++i)
-    {
-        // Configure the OnOff application to send traffic to the specified address and port
-        OnOffHelper onOffHelper(socketFactory, InetSocketAddress(address, port + i));
-        onOffHelper.SetAttribute("DataRate", DataRateValue(dataRate));
-        onOffHelper.SetAttribute("PacketSize", UintegerValue(512)); // Set packet size (default is 512 bytes)
-        onOffHelper.SetAttribute("OnTime",  StringValue("ns3::ConstantRandomVariable[Constant=1]"));
-        onOffHelper.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
-
-        // Install the OnOff application on the specified node
-        ApplicationContainer sourceApps = onOffHelper.Install(node);
-        sourceApps.Start(Seconds(1.0 + i * 0.1)); // Stagger start times slightly
-        sourceApps.Stop(Seconds(stopTime + i * 0.1)); // Stagger stop times appropriately
-
-        // Schedule tracing functions for congestion window and slow start threshold
-        Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceCwnd, nodeId, cwndWindow, port + i);
-        Simulator::Schedule(Seconds(1.0 + i * 0.1) + Seconds(0.001), &TraceSsthresh, nodeId, cwndWindow, port + i);
-    }
-}
-
-// void
-// InstallBulkSend(Ptr<Node> node,
-//                 Ipv4Address address,
-//                 uint16_t port,
-//                 std::string socketFactory,
-//                 uint32_t nodeId,
-//                 uint32_t cwndWindow,
-//                 Callback<void, uint32_t, uint32_t> CwndTrace)
-// {
-//     BulkSendHelper source(socketFactory, InetSocketAddress(address, port));
-//     source.SetAttribute("MaxBytes", UintegerValue(0));
-//     ApplicationContainer sourceApps = source.Install(node);
-//     sourceApps.Start(Seconds(10.0));
-//     Simulator::Schedule(Seconds(10.0) + Seconds(0.001), &TraceCwnd, nodeId, cwndWindow, CwndTrace);
-//     sourceApps.Stop(stopTime);
-// }
-
-//Receiver side
-// Function to install sink application
-void
-InstallPacketSink(Ptr<Node> node, uint16_t port, std::string socketFactory)
-{
-    PacketSinkHelper sink(socketFactory, InetSocketAddress(Ipv4Address::GetAny(), port));
-    ApplicationContainer sinkApps = sink.Install(node);
-    sinkApps.Start(Seconds(1.0));
-    sinkApps.Stop(stopTime);
-}
-
-
 int
 main(int argc, char* argv[])
 {
@@ -199,7 +84,10 @@ main(int argc, char* argv[])
     uint32_t delAckCount = 1;
     std::string recovery = "ns3::TcpClassicRecovery";
     std::string errorModelType = "ns3::RateErrorModel";
-
+    std::string traceFormat = "text";
+    bool asyncTraces = true;
+    std::string scheduler = "map";
+    PcapCaptureConfig pcapConfig;
 
     CommandLine cmd;
     cmd.AddValue("tcpTypeId",
@@ -213,8 +101,46 @@ main(int argc, char* argv[])
                  "Stop time for applications / simulation time will be stopTime",
                  stopTime);
     cmd.AddValue("recovery", "Recovery algorithm type to use (e.g., ns3::TcpPrrRecovery", recovery);
+    cmd.AddValue("traceFormat", "Format of the trace files: text (.dat) or binary (.bin)", traceFormat);
+    cmd.AddValue("asyncTraces", "Write trace files from a background thread", asyncTraces);
+    cmd.AddValue("scheduler",
+                 "Event scheduler: map (ns-3 default), heap, list, calendar, priority or bucket",
+                 scheduler);
+    cmd.AddValue("snapLength",
+                 "Bytes of every packet kept in the pcaps (96 keeps the headers only)",
+                 pcapConfig.snapLength);
+    cmd.AddValue("pcapSampleEvery",
+                 "Keep one in this many packets of a device in the pcaps",
+                 pcapConfig.sampleEvery);
+    cmd.AddValue("pcapDuration",
+                 "Capture only this long from the start (0 = whole run)",
+                 pcapConfig.captureFor);
+    cmd.AddValue("pcapRotateBytes",
+                 "Start a new pcap file after this many bytes (0 = never)",
+                 pcapConfig.rotateBytes);
+    cmd.AddValue("pcapRotateInterval",
+                 "Start a new pcap file after this much simulated time (0 = never)",
+                 pcapConfig.rotateInterval);
+    cmd.AddValue("pcapCompression",
+                 "Compression of the pcaps: none, gzip (.pcap.gz) or zstd (.pcap.zst)",
+                 pcapConfig.compression);
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_UNLESS(traceFormat == "text" || traceFormat == "binary",
+                        "Unknown trace format " << traceFormat);
+
+    // BucketCalendarScheduler with one bucket per packet on the 1.25 Mbps
+    // bottleneck, covering two RTTs
+    TypeId schedulerTid;
+    NS_ABORT_MSG_UNLESS(
+        TypeId::LookupByNameFailSafe(GetSchedulerTypeId(scheduler), &schedulerTid),
+        "Unknown scheduler " << scheduler);
+    if (GetSchedulerTypeId(scheduler) == "ns3::BucketCalendarScheduler")
+    {
+        ConfigureBucketScheduler(DataRate("1.25Mbps"), segmentSize + 54, MilliSeconds(40));
+    }
+    Simulator::SetScheduler(ObjectFactory(GetSchedulerTypeId(scheduler)));
+
     // TypeId qdTid;
     // NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(qdiscTypeId, &qdTid),
     //                     "TypeId " << qdiscTypeId << " not found");
@@ -316,13 +242,12 @@ main(int argc, char* argv[])
     }
 
     SystemPath::MakeDirectories(dir);
-    SystemPath::MakeDirectories(dir + "/pcap/");
-    SystemPath::MakeDirectories(dir + "/queueTraces/");
-    SystemPath::MakeDirectories(dir + "/cwndTraces/");
+
+    // Tracers built into this program
+    ConfiguredTracers tracers;
 
     // Install flow monitor on all the nodes
-    FlowMonitorHelper flowHelper;
-    Ptr<FlowMonitor> monitor = flowHelper.InstallAll();
+    tracers.flowStats.Install(MilliSeconds(1));
 
 
     // Set default parameters for queue discipline
@@ -340,33 +265,43 @@ main(int argc, char* argv[])
     // tch.Install(leftToRouter.Get(1));
 
 
-    // Open files for writing queue size and cwnd traces
-    fPlotQueue.open(dir + "queue-size.dat", std::ios::out);
-    fPlotCwnd.open(dir + "cwndTraces/n0.dat", std::ios::out);
-    fPlotSsthresh.open(dir + "cwndTraces/ssthresh.dat", std::ios::out);
+    // Trace files are written by a background thread unless asyncTraces is off
+    TraceOutputThread traceOutput;
+    traceOutput.CloseOnDestroy();
+    TraceOpener openTrace = [&](const std::string& basePath,
+                                const std::string& name,
+                                const std::string& unit,
+                                const std::string& textSuffix) {
+        std::unique_ptr<TraceWriter> writer =
+            CreateTraceWriter(traceFormat, basePath, name, unit, textSuffix);
+        return asyncTraces ? traceOutput.Wrap(std::move(writer)) : std::move(writer);
+    };
 
-    // Calls function to check queue size
-    Simulator::ScheduleNow(&CheckQueueSize, qd.Get(0));
+    // Port of the flow, also the last column of the cwnd traces
+    uint16_t port = 50000;
 
-    AsciiTraceHelper asciiTraceHelper;
-    Ptr<OutputStreamWrapper> streamWrapper;
+    // Sample the queue size every 1 ms
+    tracers.queue.Install(openTrace, dir, qd.Get(0), MilliSeconds(1));
 
     // // Create dat to store packets dropped and marked at the router
-    streamWrapper = asciiTraceHelper.CreateFileStream(dir + "/queueTraces/drop-0.dat");
-    qd.Get(0)->TraceConnectWithoutContext("Drop", MakeBoundCallback(&DropAtQueue, streamWrapper));
+    tracers.drop.Install(openTrace, dir, qd.Get(0));
+
+    // Every change of cwnd and ssthresh, in cwndTraces/n0.dat and ssthresh.dat
+    tracers.cwnd.Install(Seconds(0), segmentSize, false, "n0", "ssthresh");
+    std::vector<FlowObserver*> observers;
+    tracers.cwnd.AddTo(observers);
 
     // Install packet sink at receiver side
-    uint16_t port = 50000;
-    InstallPacketSink(rightNode.Get(0), port, "ns3::TcpSocketFactory");
+    InstallPacketSink(rightNode.Get(0), port, "ns3::TcpSocketFactory", stopTime);
     
     // Install BulkSend application
 
     InstallBulkSend(leftNode.Get(0), routerToRightIPAddress[0].GetAddress(1), port,
-                        socketFactory, leftNode.Get(0)->GetId(), 0, 1);
+                        socketFactory, stopTime, 1, observers);
 
     // // Install OnOff application
     // InstallOnOff(leftNode.Get(0), routerToRightIPAddress[0].GetAddress(1), port,
-    //                 socketFactory, leftNode.Get(0)->GetId(), 0, DataRate("100Mbps"), 1, stopTime.GetSeconds());
+    //                 socketFactory, DataRate("100Mbps"), stopTime, 1);
 
     // Ping from leftNode to rightNode
     // PingHelper pinghelper(routerToRightIPAddress[0].GetAddress(1), leftToRouterIPAddress[0].GetAddress(0));
@@ -379,28 +314,14 @@ main(int argc, char* argv[])
 
 
     // Enable PCAP on all the point to point interfaces
-    accessLink.EnablePcapAll(dir + "pcap/ns-3", true);
+    tracers.pcap.Install(dir, pcapConfig);
 
     //Simulator::Schedule(Seconds(1.1), &PrintAllRoutingTables);
     Simulator::Stop(stopTime);
     Simulator::Run();
 
-    monitor->CheckForLostPackets(); // Optional, helps in accounting for lost packets
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowHelper.GetClassifier());
-    std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats();
-    for(std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
-    {
-      
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
-        std::cout << "Flow " << i->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
-        std::cout << "  Tx Bytes:   " << i->second.txBytes << "\n";
-        std::cout << "  Rx Bytes:   " << i->second.rxBytes << "\n";
-        std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
-        std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
-        std::cout << "  Lost Packets: " << i->second.lostPackets << "\n";
-        std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / stopTime.GetSeconds() / 1024 / 1024  << " Mbps\n";
-       
-    }
+    tracers.flowStats.Write(std::cout, nullptr, stopTime);
+    tracers.cwnd.Finish(traceFormat, dir);
 
 
     // Store queue stats in a file
@@ -420,10 +341,12 @@ main(int argc, char* argv[])
     myfile << "stopTime " << stopTime.As(Time::S) << "\n";
     myfile.close();
 
+    // Also writes out and closes the trace files
     Simulator::Destroy();
 
-    fPlotQueue.close();
-    fPlotCwnd.close();
+    tracers.drop.Finish();
+    tracers.queue.Finish();
+    tracers.pcap.Finish();
 
     return 0;
 }
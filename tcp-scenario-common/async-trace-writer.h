@@ -0,0 +1,284 @@
+#ifndef ASYNC_TRACE_WRITER_H
+#define ASYNC_TRACE_WRITER_H
+
+// Moves trace output off the simulator thread. Trace sinks push fixed-size
+// records into a lock-free ring, and one background thread drains all rings
+// into the actual (text or binary) TraceWriters.
+//
+//   TraceOutputThread traceOutput;
+//   traceOutput.CloseOnDestroy();
+//   std::unique_ptr<TraceWriter> trace =
+//       traceOutput.Wrap(CreateTraceWriter("text", dir + "queue-size", "queue-size", "bytes"));
+
+#include "trace-writer.h"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Lock-free ring buffer for exactly one producer and one consumer thread
+template <typename T>
+class SpscRing
+{
+  public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    // Producer side; false if the ring is full
+    bool Push(const T& item)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == m_buffer.size())
+        {
+            return false;
+        }
+        m_buffer[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; moves up to max items to out and returns how many
+    std::size_t Pop(T* out, std::size_t max)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t n = std::min(m_head.load(std::memory_order_acquire) - tail, max);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out[i] = m_buffer[(tail + i) & m_mask];
+        }
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+  private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+class TraceOutputThread;
+
+// TraceWriter handing its records to the TraceOutputThread. Write() is called
+// on the simulator thread; the wrapped writer only runs on the output thread
+// (or on the thread calling Close(), once the writer is unregistered).
+class AsyncTraceWriter : public TraceWriter
+{
+  public:
+    AsyncTraceWriter(TraceOutputThread* output,
+                     std::unique_ptr<TraceWriter> sink,
+                     std::size_t capacity);
+    ~AsyncTraceWriter() override;
+
+    void Write(int64_t timeNs, int64_t value) override;
+    void Close() override;
+
+  private:
+    friend class TraceOutputThread;
+
+    // Consumer side: write everything currently in the ring to the sink
+    std::size_t Drain();
+
+    TraceOutputThread* m_output;
+    std::unique_ptr<TraceWriter> m_sink;
+    SpscRing<BinaryTraceRecord> m_ring;
+    bool m_closed{false};
+};
+
+// The background thread writing out all AsyncTraceWriters of a run
+class TraceOutputThread
+{
+  public:
+    // What Write() does when the ring of a writer is full
+    enum FullPolicy
+    {
+        BLOCK, // wait for the output thread (counted as a stall)
+        DROP,  // discard the record (counted as dropped)
+    };
+
+    explicit TraceOutputThread(FullPolicy policy = BLOCK, std::size_t ringCapacity = 1 << 16)
+        : m_policy(policy),
+          m_ringCapacity(ringCapacity)
+    {
+    }
+
+    ~TraceOutputThread()
+    {
+        Close();
+    }
+
+    // Make writes to sink asynchronous. The output thread is started on first use.
+    std::unique_ptr<TraceWriter> Wrap(std::unique_ptr<TraceWriter> sink)
+    {
+        auto writer = std::make_unique<AsyncTraceWriter>(this, std::move(sink), m_ringCapacity);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writers.push_back(writer.get());
+        if (!m_thread.joinable())
+        {
+            m_stop = false;
+            m_thread = std::thread(&TraceOutputThread::Run, this);
+        }
+        return writer;
+    }
+
+    // Write out and close every writer, then stop the thread
+    void Close()
+    {
+        std::vector<AsyncTraceWriter*> writers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            writers = m_writers;
+        }
+        for (AsyncTraceWriter* writer : writers)
+        {
+            writer->Close();
+        }
+        if (m_thread.joinable())
+        {
+            m_stop = true;
+            m_wake.notify_one();
+            m_thread.join();
+        }
+    }
+
+    // Close() as part of Simulator::Destroy(), so no trace is left half written
+    void CloseOnDestroy()
+    {
+        ns3::Simulator::ScheduleDestroy(&TraceOutputThread::Close, this);
+    }
+
+    // Number of writes that had to wait for the output thread
+    uint64_t GetStalls() const
+    {
+        return m_stalls.load(std::memory_order_relaxed);
+    }
+
+    // Number of records discarded because a ring was full (DROP policy)
+    uint64_t GetDropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    friend class AsyncTraceWriter;
+
+    void Run()
+    {
+        while (!m_stop)
+        {
+            std::size_t written = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (AsyncTraceWriter* writer : m_writers)
+                {
+                    written += writer->Drain();
+                }
+            }
+            if (written == 0)
+            {
+                std::unique_lock<std::mutex> lock(m_wakeMutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    void Unregister(AsyncTraceWriter* writer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writers.erase(std::remove(m_writers.begin(), m_writers.end(), writer), m_writers.end());
+    }
+
+    FullPolicy m_policy;
+    std::size_t m_ringCapacity;
+    std::mutex m_mutex; // guards m_writers and the hand-over of a writer on Close()
+    std::vector<AsyncTraceWriter*> m_writers;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<uint64_t> m_stalls{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+inline AsyncTraceWriter::AsyncTraceWriter(TraceOutputThread* output,
+                                          std::unique_ptr<TraceWriter> sink,
+                                          std::size_t capacity)
+    : m_output(output),
+      m_sink(std::move(sink)),
+      m_ring(capacity)
+{
+}
+
+inline AsyncTraceWriter::~AsyncTraceWriter()
+{
+    Close();
+}
+
+inline void
+AsyncTraceWriter::Write(int64_t timeNs, int64_t value)
+{
+    if (m_ring.Push({timeNs, value}))
+    {
+        return;
+    }
+    if (m_output->m_policy == TraceOutputThread::DROP)
+    {
+        m_output->m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_output->m_stalls.fetch_add(1, std::memory_order_relaxed);
+    do
+    {
+        m_output->m_wake.notify_one();
+        std::this_thread::yield();
+    } while (!m_ring.Push({timeNs, value}));
+}
+
+inline void
+AsyncTraceWriter::Close()
+{
+    if (m_closed)
+    {
+        return;
+    }
+    m_closed = true;
+    // Once unregistered the output thread no longer touches this writer, so
+    // the rest of the ring can be written out from here
+    m_output->Unregister(this);
+    Drain();
+    m_sink->Close();
+}
+
+inline std::size_t
+AsyncTraceWriter::Drain()
+{
+    BinaryTraceRecord batch[1024];
+    std::size_t total = 0;
+    std::size_t n;
+    while ((n = m_ring.Pop(batch, 1024)) > 0)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m_sink->Write(batch[i].timeNs, batch[i].value);
+        }
+        total += n;
+    }
+    return total;
+}
+
+#endif /* ASYNC_TRACE_WRITER_H */
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Read the binary traces (.bin) written by BinaryTraceWriter in trace-writer.h.
+
+The file is memory-mapped and its varint-coded deltas are decoded with numpy,
+a whole column at a time, into one array of timestamps and one of values:
+
+    from bintrace import BinaryTrace
+    trace = BinaryTrace("queue-size.bin")
+    for time_ns, value in trace:
+        ...
+    trace.times(), trace.values()   # numpy arrays
+
+From the command line the trace is converted back to the .dat text format
+("seconds value" per line) that the older scripts and the notebook read:
+
+    ./bintrace.py queue-size.bin > queue-size.dat
+    ./bintrace.py --info queue-size.bin
+"""
+
+import argparse
+import mmap
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"NS3TRACE"
+VERSION = 2
+# magic, version, headerSize, recordSize, reserved, name, unit
+HEADER = struct.Struct("<8sIIII20s20s")
+# Records converted to text at a time by write_text
+CHUNK = 1 << 16
+
+
+def _decode_deltas(data):
+    """Time and value deltas of the zigzag LEB128 varints in the uint8 array data"""
+    # Each varint ends with the first byte that has the high bit clear
+    ends = np.flatnonzero(data < 0x80)
+    # A trace cut short by a crash may end in a partial record
+    ends = ends[:len(ends) - len(ends) % 2]
+    starts = np.empty_like(ends)
+    starts[:1] = 0
+    starts[1:] = ends[:-1] + 1
+    lengths = ends - starts + 1
+    acc = np.zeros(len(ends), dtype=np.uint64)
+    for k in range(int(lengths.max()) if len(lengths) else 0):
+        more = np.flatnonzero(lengths > k)
+        acc[more] |= (data[starts[more] + k] & 0x7F).astype(np.uint64) << np.uint64(7 * k)
+    deltas = (acc >> np.uint64(1)).view(np.int64) ^ -(acc & np.uint64(1)).view(np.int64)
+    return deltas[0::2], deltas[1::2]
+
+
+class BinaryTrace:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        try:
+            magic, self.version, header_size, _, _, name, unit = HEADER.unpack_from(data)
+            if magic != MAGIC:
+                raise ValueError("%s is not a binary trace" % path)
+            if self.version != VERSION:
+                raise ValueError("%s: unsupported version %d" % (path, self.version))
+            self.name = name.rstrip(b"\0").decode()
+            self.unit = unit.rstrip(b"\0").decode()
+            times, values = _decode_deltas(np.frombuffer(data, dtype=np.uint8, offset=header_size))
+            # Deltas from 0, wrapping around like the int64 arithmetic of the writer
+            self._times = np.cumsum(times, dtype=np.int64)
+            self._values = np.cumsum(values, dtype=np.int64)
+        finally:
+            data.close()
+
+    def __len__(self):
+        return len(self._times)
+
+    def __getitem__(self, i):
+        return int(self._times[i]), int(self._values[i])
+
+    def __iter__(self):
+        for begin in range(0, len(self), CHUNK):
+            yield from zip(self._times[begin:begin + CHUNK].tolist(),
+                           self._values[begin:begin + CHUNK].tolist())
+
+    def times(self):
+        """Timestamps in seconds"""
+        return self._times / 1e9
+
+    def values(self):
+        return self._values
+
+    def close(self):
+        pass
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
+def write_text(trace, out):
+    """Write the trace in the .dat text format"""
+    for time_ns, value in trace:
+        out.write("%g %d\n" % (time_ns / 1e9, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("trace", help="binary trace file (.bin)")
+    parser.add_argument("-o", "--output", help="write the .dat text here instead of stdout")
+    parser.add_argument("--info", action="store_true", help="only print the header and record count")
+    args = parser.parse_args()
+
+    with BinaryTrace(args.trace) as trace:
+        if args.info:
+            print("name: %s\nunit: %s\nversion: %d\nrecords: %d" % (trace.name, trace.unit, trace.version, len(trace)))
+            return
+        out = open(args.output, "w") if args.output else sys.stdout
+        write_text(trace, out)
+        if args.output:
+            out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,254 @@
+#ifndef BUCKET_SCHEDULER_H
+#define BUCKET_SCHEDULER_H
+
+// Event scheduler for long runs over a fast bottleneck, and the choice of
+// scheduler of the scenarios.
+//
+// Nearly all pending events of these runs are packet transmissions,
+// receptions and timers a few serialization times to a few RTTs ahead. The
+// BucketCalendarScheduler keeps them in a ring of fixed-width time buckets
+// (a calendar queue without resizing) that covers BucketWidth x Buckets of
+// simulated time from the current bucket on. Inserting an event is an append
+// to its bucket; a bucket is only sorted when the simulation reaches it, and
+// holds a handful of events if BucketWidth is about the serialization time of
+// a packet on the bottleneck. Events beyond the ring go to an ordered map and
+// are moved into the ring as it advances.
+//
+// Like every ns-3 scheduler it orders events by time and then by insertion,
+// so the choice of scheduler does not change the results.
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class BucketCalendarScheduler : public ns3::Scheduler
+{
+  public:
+    static ns3::TypeId GetTypeId()
+    {
+        static ns3::TypeId tid =
+            ns3::TypeId("ns3::BucketCalendarScheduler")
+                .SetParent<ns3::Scheduler>()
+                .AddConstructor<BucketCalendarScheduler>()
+                .AddAttribute("BucketWidth",
+                              "Simulated time covered by one bucket",
+                              ns3::TimeValue(ns3::MicroSeconds(10)),
+                              ns3::MakeTimeAccessor(&BucketCalendarScheduler::SetBucketWidth),
+                              ns3::MakeTimeChecker(ns3::TimeStep(1)))
+                .AddAttribute("Buckets",
+                              "Number of buckets of the ring",
+                              ns3::UintegerValue(4096),
+                              ns3::MakeUintegerAccessor(&BucketCalendarScheduler::SetBuckets),
+                              ns3::MakeUintegerChecker<uint32_t>(1));
+        return tid;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        Place(ev);
+        m_count++;
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_count == 0;
+    }
+
+    Event PeekNext() const override
+    {
+        Advance();
+        return m_buckets[m_current].back();
+    }
+
+    Event RemoveNext() override
+    {
+        Advance();
+        Event ev = m_buckets[m_current].back();
+        m_buckets[m_current].pop_back();
+        m_inRing--;
+        m_count--;
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        m_count--;
+        uint64_t ts = ev.key.m_ts;
+        if (ts >= GetHorizon())
+        {
+            m_overflow.erase(ev.key);
+            return;
+        }
+        // Erasing keeps the current bucket sorted
+        std::vector<Event>& bucket = m_buckets[GetBucket(ts)];
+        auto it = std::find_if(bucket.begin(), bucket.end(), [&ev](const Event& e) {
+            return e.key.m_uid == ev.key.m_uid;
+        });
+        NS_ASSERT(it != bucket.end());
+        bucket.erase(it);
+        m_inRing--;
+    }
+
+  private:
+    void SetBucketWidth(ns3::Time width)
+    {
+        NS_ABORT_MSG_UNLESS(m_count == 0, "BucketWidth can only be set while empty");
+        m_width = width.GetTimeStep();
+        m_windowStart = 0;
+    }
+
+    void SetBuckets(uint32_t buckets)
+    {
+        NS_ABORT_MSG_UNLESS(m_count == 0, "Buckets can only be set while empty");
+        m_buckets.assign(buckets, {});
+        m_current = 0;
+        m_windowStart = 0;
+    }
+
+    // End of the time covered by the ring
+    uint64_t GetHorizon() const
+    {
+        return m_windowStart + m_width * m_buckets.size();
+    }
+
+    // Bucket of an event before the horizon. Events before the current
+    // bucket (inserted after the ring advanced past the current time to the
+    // next event) belong to the current bucket as well.
+    std::size_t GetBucket(uint64_t ts) const
+    {
+        if (ts < m_windowStart + m_width)
+        {
+            return m_current;
+        }
+        return (m_current + (ts - m_windowStart) / m_width) % m_buckets.size();
+    }
+
+    void Place(const Event& ev)
+    {
+        uint64_t ts = ev.key.m_ts;
+        if (ts >= GetHorizon())
+        {
+            m_overflow.emplace(ev.key, ev.impl);
+            return;
+        }
+        std::size_t index = GetBucket(ts);
+        std::vector<Event>& bucket = m_buckets[index];
+        if (index == m_current)
+        {
+            // The current bucket is sorted, last event first
+            auto pos = std::upper_bound(bucket.begin(),
+                                        bucket.end(),
+                                        ev,
+                                        [](const Event& a, const Event& b) { return b < a; });
+            bucket.insert(pos, ev);
+        }
+        else
+        {
+            bucket.push_back(ev);
+        }
+        m_inRing++;
+    }
+
+    // Move the ring forward to the bucket of the next event and sort it
+    void Advance() const
+    {
+        NS_ASSERT(m_count > 0);
+        if (!m_buckets[m_current].empty())
+        {
+            return;
+        }
+        do
+        {
+            if (m_inRing == 0)
+            {
+                // Nothing left in the ring: restart it at the first event beyond
+                uint64_t ts = m_overflow.begin()->first.m_ts;
+                m_windowStart = ts - ts % m_width;
+            }
+            else
+            {
+                m_current = (m_current + 1) % m_buckets.size();
+                m_windowStart += m_width;
+            }
+            Pull();
+        } while (m_buckets[m_current].empty());
+        Sort();
+    }
+
+    // Move the overflow events that are now within the ring into it
+    void Pull() const
+    {
+        uint64_t horizon = GetHorizon();
+        while (!m_overflow.empty() && m_overflow.begin()->first.m_ts < horizon)
+        {
+            auto first = m_overflow.begin();
+            Event ev;
+            ev.impl = first->second;
+            ev.key = first->first;
+            m_overflow.erase(first);
+            std::vector<Event>& bucket = m_buckets[GetBucket(ev.key.m_ts)];
+            bucket.push_back(ev);
+            m_inRing++;
+        }
+    }
+
+    void Sort() const
+    {
+        std::vector<Event>& bucket = m_buckets[m_current];
+        std::sort(bucket.begin(), bucket.end(), [](const Event& a, const Event& b) {
+            return b < a;
+        });
+    }
+
+    // The ring moves forward in the const PeekNext() as well
+    mutable std::vector<std::vector<Event>> m_buckets = std::vector<std::vector<Event>>(4096);
+    mutable std::size_t m_current{0};
+    mutable uint64_t m_windowStart{0}; // start of the current bucket
+    mutable uint64_t m_inRing{0};
+    mutable std::map<EventKey, ns3::EventImpl*> m_overflow;
+    uint64_t m_width{10000};
+    uint64_t m_count{0};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BucketCalendarScheduler);
+
+// TypeId of the scheduler named name: map (the ns-3 default), heap, list,
+// calendar, priority or bucket (BucketCalendarScheduler); full TypeIds are
+// taken as is
+inline std::string
+GetSchedulerTypeId(const std::string& name)
+{
+    static const std::map<std::string, std::string> names = {
+        {"map", "ns3::MapScheduler"},
+        {"heap", "ns3::HeapScheduler"},
+        {"list", "ns3::ListScheduler"},
+        {"calendar", "ns3::CalendarScheduler"},
+        {"priority", "ns3::PriorityQueueScheduler"},
+        {"bucket", "ns3::BucketCalendarScheduler"},
+    };
+    auto it = names.find(name);
+    return it != names.end() ? it->second : name;
+}
+
+// Size BucketCalendarScheduler for a bottleneck: one bucket per serialization
+// time of a packetSize packet, and a ring covering span (e.g. a few RTTs),
+// rounded up to a power of two of at most 2^20 buckets
+inline void
+ConfigureBucketScheduler(ns3::DataRate rate, uint32_t packetSize, ns3::Time span)
+{
+    ns3::Time width = rate.CalculateBytesTxTime(packetSize);
+    uint64_t buckets = 1;
+    while (buckets < (1u << 20) && width * static_cast<int64_t>(buckets) < span)
+    {
+        buckets *= 2;
+    }
+    ns3::Config::SetDefault("ns3::BucketCalendarScheduler::BucketWidth", ns3::TimeValue(width));
+    ns3::Config::SetDefault("ns3::BucketCalendarScheduler::Buckets",
+                            ns3::UintegerValue(buckets));
+}
+
+#endif /* BUCKET_SCHEDULER_H */
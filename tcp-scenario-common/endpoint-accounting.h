@@ -0,0 +1,144 @@
+#ifndef ENDPOINT_ACCOUNTING_H
+#define ENDPOINT_ACCOUNTING_H
+
+// Per-flow goodput, retransmission and RTT accounting at the endpoints only,
+// as a lighter alternative to FlowMonitorHelper::InstallAll().
+//
+// FlowMonitor classifies every packet on every node, including the routers.
+// This only connects to the Tx and RTT trace sources of each sender socket
+// and reads the received bytes from the PacketSink of the flow at the end.
+// Retransmissions are counted exactly: a data segment that starts below the
+// highest sequence number already sent is a retransmission.
+//
+//   EndpointAccounting accounting;
+//   accounting.AddSink(port, sink);
+//   InstallBulkSend(..., {&accounting});
+//   ...
+//   accounting.Write(resultFile, Simulator::Now());
+
+#include "flow-observer.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+class EndpointAccounting : public FlowObserver
+{
+  public:
+    // sink receives the flow to port
+    void AddSink(uint16_t port, ns3::Ptr<ns3::PacketSink> sink)
+    {
+        m_sinks[port] = sink;
+    }
+
+    void Add(ns3::Ptr<ns3::BulkSendApplication> app, ns3::Time start, uint16_t port) override
+    {
+        m_flows.push_back(std::make_unique<Flow>());
+        Flow* flow = m_flows.back().get();
+        flow->port = port;
+        flow->start = start;
+        ns3::Simulator::Schedule(GetBindDelay(start), &EndpointAccounting::Bind, flow, app);
+    }
+
+    // One block per flow in the layout of the FlowMonitor results in
+    // goodput_retransmission_results.txt. Bytes are TCP payload; throughput
+    // is in decimal Mbps from the start of the flow until end.
+    void Write(std::ostream& os, ns3::Time end) const
+    {
+        uint32_t id = 1;
+        for (const std::unique_ptr<Flow>& flow : m_flows)
+        {
+            auto sink = m_sinks.find(flow->port);
+            uint64_t rxBytes = sink != m_sinks.end() ? sink->second->GetTotalRx() : 0;
+            os << "Flow " << id++ << " (" << flow->source << " -> " << flow->destination << ")\n";
+            os << "  Tx Bytes:   " << flow->txBytes << "\n";
+            os << "  Rx Bytes:   " << rxBytes << "\n";
+            os << "  Tx Segments: " << flow->txSegments << "\n";
+            os << "  Throughput: " << rxBytes * 8.0 / (end - flow->start).GetSeconds() / 1e6
+               << " Mbps\n";
+            os << "  Retransmissions: " << flow->retransmissions << "\n";
+            os << "  Retransmitted Bytes: " << flow->retransmittedBytes << "\n";
+            if (flow->rttSamples > 0)
+            {
+                os << "  Average RTT: " << flow->rttSumNs / 1e9 / flow->rttSamples << "\n";
+            }
+        }
+    }
+
+  private:
+    struct Flow
+    {
+        uint16_t port;
+        ns3::Time start;
+        ns3::Ipv4Address source;
+        ns3::Ipv4Address destination;
+        uint64_t txBytes{0};
+        uint64_t txSegments{0};
+        uint64_t retransmissions{0};
+        uint64_t retransmittedBytes{0};
+        bool sent{false};
+        ns3::SequenceNumber32 highestSent;
+        int64_t rttSumNs{0};
+        uint64_t rttSamples{0};
+    };
+
+    static void Bind(Flow* flow, ns3::Ptr<ns3::BulkSendApplication> app)
+    {
+        ns3::Ptr<ns3::Socket> socket = app->GetSocket();
+        NS_ABORT_MSG_UNLESS(socket, "BulkSend application of port " << flow->port
+                                                                    << " has no socket");
+        ns3::Address address;
+        socket->GetSockName(address);
+        flow->source = ns3::InetSocketAddress::ConvertFrom(address).GetIpv4();
+        socket->GetPeerName(address);
+        flow->destination = ns3::InetSocketAddress::ConvertFrom(address).GetIpv4();
+        socket->TraceConnectWithoutContext("Tx",
+                                           ns3::MakeBoundCallback(&EndpointAccounting::Tx, flow));
+        socket->TraceConnectWithoutContext("RTT",
+                                           ns3::MakeBoundCallback(&EndpointAccounting::Rtt, flow));
+    }
+
+    static void Tx(Flow* flow,
+                   ns3::Ptr<const ns3::Packet> packet,
+                   const ns3::TcpHeader& header,
+                   ns3::Ptr<const ns3::TcpSocketBase> socket)
+    {
+        uint32_t size = packet->GetSize();
+        if (size == 0)
+        {
+            return; // pure ACK or SYN/FIN
+        }
+        ns3::SequenceNumber32 seq = header.GetSequenceNumber();
+        flow->txBytes += size;
+        flow->txSegments++;
+        if (flow->sent && seq < flow->highestSent)
+        {
+            flow->retransmissions++;
+            flow->retransmittedBytes += size;
+        }
+        if (!flow->sent || seq + size > flow->highestSent)
+        {
+            flow->highestSent = seq + size;
+            flow->sent = true;
+        }
+    }
+
+    static void Rtt(Flow* flow, ns3::Time oldRtt, ns3::Time newRtt)
+    {
+        if (newRtt.IsStrictlyPositive())
+        {
+            flow->rttSumNs += newRtt.GetNanoSeconds();
+            flow->rttSamples++;
+        }
+    }
+
+    std::vector<std::unique_ptr<Flow>> m_flows;
+    std::map<uint16_t, ns3::Ptr<ns3::PacketSink>> m_sinks;
+};
+
+#endif /* ENDPOINT_ACCOUNTING_H */
@@ -0,0 +1,82 @@
+#ifndef FLOW_HISTOGRAMS_H
+#define FLOW_HISTOGRAMS_H
+
+// Percentiles and compact serialization of the per-flow delay and jitter
+// histograms FlowMonitor keeps (FlowMonitor::FlowStats::delayHistogram, ...).
+//
+// The compact form is one line per histogram with the bin width and only the
+// non-empty bins as index:count pairs:
+//
+//   <flow> <source> <destination> <name> <bin width (s)> <index>:<count> ...
+//
+// Histograms of the same flow and bin width from several trials are merged by
+// adding up the counts of equal indices.
+
+#include "ns3/flow-monitor-module.h"
+#include "ns3/internet-module.h"
+
+#include <ostream>
+#include <string>
+
+// Value below which a fraction p (0..1) of the samples fall, interpolated
+// linearly within the bin; 0 for an empty histogram
+inline double
+GetHistogramPercentile(const ns3::Histogram& histogram, double p)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < histogram.GetNBins(); ++i)
+    {
+        total += histogram.GetBinCount(i);
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    double target = p * total;
+    uint64_t below = 0;
+    for (uint32_t i = 0; i < histogram.GetNBins(); ++i)
+    {
+        uint32_t count = histogram.GetBinCount(i);
+        if (count > 0 && below + count >= target)
+        {
+            return histogram.GetBinStart(i) + histogram.GetBinWidth(i) * (target - below) / count;
+        }
+        below += count;
+    }
+    return histogram.GetBinEnd(histogram.GetNBins() - 1);
+}
+
+// binWidth is the one the histogram was created with (FlowMonitor's
+// DelayBinWidth or JitterBinWidth), as an empty histogram has no bins
+inline void
+WriteCompactHistogram(std::ostream& os,
+                      ns3::FlowId flow,
+                      const ns3::Ipv4FlowClassifier::FiveTuple& tuple,
+                      const std::string& name,
+                      double binWidth,
+                      const ns3::Histogram& histogram)
+{
+    os << flow << " " << tuple.sourceAddress << " " << tuple.destinationAddress << " " << name
+       << " " << binWidth;
+    for (uint32_t i = 0; i < histogram.GetNBins(); ++i)
+    {
+        if (histogram.GetBinCount(i) > 0)
+        {
+            os << " " << i << ":" << histogram.GetBinCount(i);
+        }
+    }
+    os << "\n";
+}
+
+// "p50 p90 p99 p99.9" of histogram, in its unit (seconds for delay and jitter)
+inline void
+WriteHistogramPercentiles(std::ostream& os, const ns3::Histogram& histogram)
+{
+    static const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        os << (i > 0 ? " " : "") << GetHistogramPercentile(histogram, percentiles[i]);
+    }
+}
+
+#endif /* FLOW_HISTOGRAMS_H */
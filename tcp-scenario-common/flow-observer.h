@@ -0,0 +1,26 @@
+#ifndef FLOW_OBSERVER_H
+#define FLOW_OBSERVER_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+
+// Something that follows the sender side of every BulkSend flow of a
+// scenario (e.g. FlowTracer, EndpointAccounting), handed to InstallBulkSend
+class FlowObserver
+{
+  public:
+    virtual ~FlowObserver() = default;
+
+    // app is the sender of the flow to port; it creates its socket when it
+    // starts at start
+    virtual void Add(ns3::Ptr<ns3::BulkSendApplication> app, ns3::Time start, uint16_t port) = 0;
+
+  protected:
+    // Delay until app has created its socket, if it starts at start
+    static ns3::Time GetBindDelay(ns3::Time start)
+    {
+        return start - ns3::Simulator::Now() + ns3::TimeStep(1);
+    }
+};
+
+#endif /* FLOW_OBSERVER_H */
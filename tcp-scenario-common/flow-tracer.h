@@ -0,0 +1,388 @@
+#ifndef FLOW_TRACER_H
+#define FLOW_TRACER_H
+
+// Per-flow traces of the TCP sender state of many concurrent flows: cwnd and
+// ssthresh for every variant and, for TcpBbr, the state machine, bottleneck
+// bandwidth estimate, min RTT estimate and pacing rate.
+//
+// The trace sinks are connected directly to the socket of each BulkSend
+// application right after it has been created, instead of resolving a
+// /NodeList/.../SocketList/K/CongestionWindow path through Config for every
+// flow. Every flow keeps fixed-size (time, variable, value) records in its
+// own buffer. A record is only taken when a value changed. With a sample
+// interval, a change opens an interval in which it is recorded right away;
+// further changes inside it are held, and the last of them is recorded with
+// its own time once the interval is over (or at the end of the run), so every
+// interval ends on its true value. BBR state changes are always recorded.
+// The buffers are written out at the end of the run, one trace per flow and
+// variable, in the format of the other traces.
+//
+//   FlowTracer flowTracer(MilliSeconds(10), segmentSize, traceBbr);
+//   flowTracer.Add(bulkSendApp, Seconds(1.0), port);
+//   ...
+//   flowTracer.Write("text", dir + "cwndTraces/");
+//   flowTracer.WriteBbrSummary(bbrStatsFile);
+
+#include "flow-observer.h"
+#include "trace-writer.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class FlowTracer : public FlowObserver
+{
+  public:
+    // sampleInterval 0 records every change. cwnd and ssthresh are written in
+    // segments of segmentSize bytes.
+    FlowTracer(ns3::Time sampleInterval, uint32_t segmentSize, bool traceBbr = false)
+        : m_sampleInterval(sampleInterval.GetNanoSeconds()),
+          m_segmentSize(segmentSize),
+          m_traceBbr(traceBbr)
+    {
+    }
+
+    // Trace the socket app creates when it starts. port identifies the flow
+    // in the output.
+    void Add(ns3::Ptr<ns3::BulkSendApplication> app, ns3::Time start, uint16_t port) override
+    {
+        m_flows.push_back(std::make_unique<Flow>());
+        Flow* flow = m_flows.back().get();
+        flow->tracer = this;
+        flow->port = port;
+        ns3::Simulator::Schedule(GetBindDelay(start), &FlowTracer::Bind, flow, app);
+    }
+
+    std::size_t GetFlowCount() const
+    {
+        return m_flows.size();
+    }
+
+    // Write the traces <dir><variable>-<port> of every flow: cwnd and
+    // ssthresh (segments) and, for BBR flows, bbr-state, btlbw and
+    // pacing-rate (kbit/s) and min-rtt (us). The text format has the port as
+    // third column like the cwnd traces of tcp-reno-custom.
+    void Write(const std::string& format, const std::string& dir)
+    {
+        for (const std::unique_ptr<Flow>& flow : m_flows)
+        {
+            std::string port = std::to_string(flow->port);
+            std::unique_ptr<TraceWriter> writers[VARIABLES];
+            for (uint32_t v = 0; v < VARIABLES; ++v)
+            {
+                // The last value of the final interval
+                Flush(*flow, v);
+                if (flow->seen[v])
+                {
+                    writers[v] = CreateTraceWriter(format,
+                                                   dir + VARIABLE_INFO[v].name + "-" + port,
+                                                   VARIABLE_INFO[v].name,
+                                                   VARIABLE_INFO[v].unit,
+                                                   " " + port);
+                }
+            }
+            for (const Record& record : flow->records)
+            {
+                uint32_t value = record.value;
+                if (record.variable == CWND || record.variable == SSTHRESH)
+                {
+                    value /= m_segmentSize;
+                }
+                writers[record.variable]->Write(record.timeNs, value);
+            }
+            for (std::unique_ptr<TraceWriter>& writer : writers)
+            {
+                if (writer)
+                {
+                    writer->Close();
+                }
+            }
+        }
+    }
+
+    // Write the cwnd and ssthresh of all flows into one trace each,
+    // <dir><cwndName> and <dir><ssthreshName>, in time order with the port as
+    // third column: the layout of n0.dat and ssthresh.dat of tcp-reno-custom.
+    // The binary format has no port column, so it is written per flow.
+    void WriteMerged(const std::string& format,
+                     const std::string& dir,
+                     const std::string& cwndName,
+                     const std::string& ssthreshName)
+    {
+        if (format == "binary")
+        {
+            Write(format, dir);
+            return;
+        }
+        for (Variable variable : {CWND, SSTHRESH})
+        {
+            struct Line
+            {
+                int64_t timeNs;
+                uint32_t value;
+                uint16_t port;
+            };
+
+            std::vector<Line> lines;
+            for (const std::unique_ptr<Flow>& flow : m_flows)
+            {
+                Flush(*flow, variable);
+                for (const Record& record : flow->records)
+                {
+                    if (record.variable == variable)
+                    {
+                        lines.push_back({record.timeNs, record.value / m_segmentSize, flow->port});
+                    }
+                }
+            }
+            std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+                return a.timeNs < b.timeNs;
+            });
+            std::string name = variable == CWND ? cwndName : ssthreshName;
+            std::ofstream out(dir + name + ".dat");
+            NS_ABORT_MSG_UNLESS(out.is_open(), "Cannot write trace " << dir << name << ".dat");
+            for (const Line& line : lines)
+            {
+                out << line.timeNs / 1e9 << " " << line.value << " " << line.port << "\n";
+            }
+        }
+    }
+
+    // Time spent in each BBR state and number of ProbeRTT episodes, for every
+    // BBR flow and in total
+    void WriteBbrSummary(std::ostream& os) const
+    {
+        static const char* const states[] = {"Startup", "Drain", "ProbeBW", "ProbeRTT"};
+        int64_t now = ns3::Simulator::Now().GetNanoSeconds();
+        double total[4] = {0, 0, 0, 0};
+        uint32_t totalProbeRtt = 0;
+        for (const std::unique_ptr<Flow>& flow : m_flows)
+        {
+            if (!flow->seen[BBR_STATE])
+            {
+                continue;
+            }
+            double seconds[4] = {0, 0, 0, 0};
+            uint32_t probeRtt = 0;
+            const Record* last = nullptr;
+            for (const Record& record : flow->records)
+            {
+                if (record.variable != BBR_STATE)
+                {
+                    continue;
+                }
+                if (last != nullptr && last->value < 4)
+                {
+                    seconds[last->value] += (record.timeNs - last->timeNs) / 1e9;
+                }
+                probeRtt += record.value == PROBE_RTT ? 1 : 0;
+                last = &record;
+            }
+            if (last != nullptr && last->value < 4)
+            {
+                seconds[last->value] += (now - last->timeNs) / 1e9;
+            }
+            os << "Flow " << flow->port << ":";
+            for (uint32_t s = 0; s < 4; ++s)
+            {
+                os << " " << states[s] << " " << seconds[s] << " s,";
+                total[s] += seconds[s];
+            }
+            os << " ProbeRTT episodes " << probeRtt << "\n";
+            totalProbeRtt += probeRtt;
+        }
+        os << "All flows:";
+        for (uint32_t s = 0; s < 4; ++s)
+        {
+            os << " " << states[s] << " " << total[s] << " s,";
+        }
+        os << " ProbeRTT episodes " << totalProbeRtt << "\n";
+    }
+
+  private:
+    enum Variable : uint32_t
+    {
+        CWND,
+        SSTHRESH,
+        BBR_STATE,
+        BTL_BW,
+        MIN_RTT,
+        PACING_RATE,
+        VARIABLES
+    };
+
+    struct VariableInfo
+    {
+        const char* name;
+        const char* unit;
+    };
+
+    static constexpr VariableInfo VARIABLE_INFO[VARIABLES] = {
+        {"cwnd", "segments"},
+        {"ssthresh", "segments"},
+        {"bbr-state", "state"},
+        {"btlbw", "kbps"},
+        {"min-rtt", "us"},
+        {"pacing-rate", "kbps"},
+    };
+
+    // Value of TcpBbr::GetBbrState() in ProbeRTT
+    static constexpr uint32_t PROBE_RTT = 3;
+    // Window of the min RTT filter, as TcpBbr's RttWindowLength default
+    static constexpr int64_t MIN_RTT_WINDOW_NS = 10000000000;
+
+    // One fixed-size record of a flow
+    struct Record
+    {
+        int64_t timeNs;
+        uint32_t variable;
+        uint32_t value; // bytes, kbit/s, us or BBR state
+    };
+
+    struct Flow
+    {
+        FlowTracer* tracer;
+        uint16_t port;
+        ns3::Ptr<ns3::TcpBbr> bbr;
+        bool seen[VARIABLES]{};
+        uint32_t current[VARIABLES]{};
+        uint32_t recorded[VARIABLES]{};
+        int64_t changedNs[VARIABLES]{}; // time of current
+        int64_t nextSampleNs[VARIABLES]{};
+        int64_t minRttNs{0};
+        int64_t minRttStampNs{0};
+        std::vector<Record> records;
+    };
+
+    static void Bind(Flow* flow, ns3::Ptr<ns3::BulkSendApplication> app)
+    {
+        ns3::Ptr<ns3::Socket> socket = app->GetSocket();
+        NS_ABORT_MSG_UNLESS(socket, "BulkSend application of port " << flow->port
+                                                                    << " has no socket");
+        socket->TraceConnectWithoutContext("CongestionWindow",
+                                           ns3::MakeBoundCallback(&FlowTracer::CwndChange, flow));
+        socket->TraceConnectWithoutContext(
+            "SlowStartThreshold",
+            ns3::MakeBoundCallback(&FlowTracer::SsthreshChange, flow));
+        if (!flow->tracer->m_traceBbr)
+        {
+            return;
+        }
+        ns3::PointerValue congestionOps;
+        if (socket->GetAttributeFailSafe("CongestionOps", congestionOps))
+        {
+            flow->bbr = ns3::DynamicCast<ns3::TcpBbr>(congestionOps.Get<ns3::TcpCongestionOps>());
+        }
+        if (!flow->bbr)
+        {
+            return;
+        }
+        socket->TraceConnectWithoutContext(
+            "PacingRate",
+            ns3::MakeBoundCallback(&FlowTracer::PacingRateChange, flow));
+        socket->TraceConnectWithoutContext("RTT",
+                                           ns3::MakeBoundCallback(&FlowTracer::RttSample, flow));
+    }
+
+    static void CwndChange(Flow* flow, uint32_t oldCwnd, uint32_t newCwnd)
+    {
+        int64_t now = ns3::Simulator::Now().GetNanoSeconds();
+        flow->tracer->Observe(*flow, CWND, newCwnd, now);
+        // The state machine advances on ACKs, which also update cwnd
+        if (flow->bbr)
+        {
+            flow->tracer->Observe(*flow, BBR_STATE, flow->bbr->GetBbrState(), now);
+        }
+    }
+
+    static void SsthreshChange(Flow* flow, uint32_t oldSsthresh, uint32_t newSsthresh)
+    {
+        flow->tracer->Observe(*flow, SSTHRESH, newSsthresh, ns3::Simulator::Now().GetNanoSeconds());
+    }
+
+    // TcpBbr sets the pacing rate to pacing gain x BtlBw, so the estimate is
+    // recovered from the two
+    static void PacingRateChange(Flow* flow, ns3::DataRate oldRate, ns3::DataRate newRate)
+    {
+        int64_t now = ns3::Simulator::Now().GetNanoSeconds();
+        flow->tracer->Observe(*flow, PACING_RATE, newRate.GetBitRate() / 1000, now);
+        double gain = flow->bbr->GetPacingGain();
+        if (gain > 0)
+        {
+            flow->tracer->Observe(*flow, BTL_BW, newRate.GetBitRate() / gain / 1000, now);
+        }
+        flow->tracer->Observe(*flow, BBR_STATE, flow->bbr->GetBbrState(), now);
+    }
+
+    // Windowed minimum of the RTT samples, like the min RTT filter of TcpBbr
+    static void RttSample(Flow* flow, ns3::Time oldRtt, ns3::Time newRtt)
+    {
+        int64_t now = ns3::Simulator::Now().GetNanoSeconds();
+        int64_t rtt = newRtt.GetNanoSeconds();
+        if (rtt <= 0)
+        {
+            return;
+        }
+        if (flow->minRttNs == 0 || rtt <= flow->minRttNs ||
+            now - flow->minRttStampNs > MIN_RTT_WINDOW_NS)
+        {
+            flow->minRttNs = rtt;
+            flow->minRttStampNs = now;
+        }
+        flow->tracer->Observe(*flow, MIN_RTT, flow->minRttNs / 1000, now);
+    }
+
+    // Take a record of value if it changed and no sample interval of variable
+    // is open; otherwise hold it as the last value of the interval
+    void Observe(Flow& flow, Variable variable, uint32_t value, int64_t nowNs)
+    {
+        if (flow.seen[variable] && flow.current[variable] == value)
+        {
+            return;
+        }
+        if (flow.seen[variable] && variable != BBR_STATE && nowNs < flow.nextSampleNs[variable])
+        {
+            flow.current[variable] = value;
+            flow.changedNs[variable] = nowNs;
+            return;
+        }
+        // The interval is over: its last value first
+        Flush(flow, variable);
+        flow.current[variable] = value;
+        flow.changedNs[variable] = nowNs;
+        if (flow.seen[variable] && flow.recorded[variable] == value)
+        {
+            return;
+        }
+        flow.records.push_back({nowNs, variable, value});
+        flow.seen[variable] = true;
+        flow.recorded[variable] = value;
+        flow.nextSampleNs[variable] = nowNs + m_sampleInterval;
+    }
+
+    // Record the value held in the last interval of variable, if it differs
+    // from the one recorded
+    static void Flush(Flow& flow, uint32_t variable)
+    {
+        if (flow.seen[variable] && flow.current[variable] != flow.recorded[variable])
+        {
+            flow.records.push_back({flow.changedNs[variable], variable, flow.current[variable]});
+            flow.recorded[variable] = flow.current[variable];
+        }
+    }
+
+    int64_t m_sampleInterval;
+    uint32_t m_segmentSize;
+    bool m_traceBbr;
+    // Flows are referenced by their trace sinks, so they must not move
+    std::vector<std::unique_ptr<Flow>> m_flows;
+};
+
+#endif /* FLOW_TRACER_H */
@@ -0,0 +1,123 @@
+#ifndef GOODPUT_SAMPLER_H
+#define GOODPUT_SAMPLER_H
+
+// Goodput time series of the PacketSinks of a scenario.
+//
+// Received bytes are added to fixed-width bins of an array allocated up front
+// for the whole run, so the Rx trace sink does no allocation. At the end the
+// sampler reports the goodput over the active period (from start, when the
+// sinks and the first sender start) and over the steady part after a warm-up,
+// both in decimal Mbit/s like the configured link rates, and writes the bins
+// as a trace.
+//
+//   GoodputSampler goodput(Seconds(1.0), stopTime, MilliSeconds(100), Seconds(5));
+//   goodput.Add(sink);
+//   ...
+//   goodput.Finish();
+//   goodput.Print(resultFile);
+//   goodput.Write(writer.get());
+
+#include "trace-writer.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+class GoodputSampler
+{
+  public:
+    GoodputSampler(ns3::Time start, ns3::Time stop, ns3::Time binWidth, ns3::Time warmup)
+        : m_startNs(start.GetNanoSeconds()),
+          m_binNs(binWidth.GetNanoSeconds()),
+          m_warmupEndNs(start.GetNanoSeconds() + warmup.GetNanoSeconds()),
+          m_endNs(stop.GetNanoSeconds())
+    {
+        NS_ABORT_MSG_UNLESS(m_binNs > 0, "The goodput bin width must be positive");
+        int64_t span = m_endNs > m_startNs ? m_endNs - m_startNs : 0;
+        m_bins.assign((span + m_binNs - 1) / m_binNs, 0);
+    }
+
+    void Add(ns3::Ptr<ns3::PacketSink> sink)
+    {
+        sink->TraceConnectWithoutContext("Rx", ns3::MakeCallback(&GoodputSampler::Rx, this));
+    }
+
+    // The run ended now, possibly before stop
+    void Finish()
+    {
+        m_endNs = ns3::Simulator::Now().GetNanoSeconds();
+    }
+
+    // Mbit/s over the active period
+    double GetGoodput() const
+    {
+        return GetRate(m_totalBytes, m_endNs - m_startNs);
+    }
+
+    // Mbit/s after the warm-up, 0 if the run ended within it
+    double GetSteadyGoodput() const
+    {
+        return GetRate(m_steadyBytes, m_endNs - m_warmupEndNs);
+    }
+
+    void Print(std::ostream& os) const
+    {
+        os << "Active Goodput: " << GetGoodput() << " Mbps (from " << m_startNs / 1e9 << " s)\n";
+        os << "Steady Goodput: " << GetSteadyGoodput() << " Mbps (from " << m_warmupEndNs / 1e9
+           << " s)\n";
+    }
+
+    // One record per bin up to the end of the run: bin start, goodput in bit/s
+    void Write(TraceWriter* writer) const
+    {
+        for (std::size_t i = 0; i < m_bins.size(); ++i)
+        {
+            int64_t binStart = m_startNs + static_cast<int64_t>(i) * m_binNs;
+            if (binStart >= m_endNs)
+            {
+                break;
+            }
+            int64_t width = std::min(m_binNs, m_endNs - binStart);
+            writer->Write(binStart, static_cast<int64_t>(m_bins[i] * 8e9 / width));
+        }
+    }
+
+  private:
+    void Rx(ns3::Ptr<const ns3::Packet> packet, const ns3::Address& from)
+    {
+        int64_t now = ns3::Simulator::Now().GetNanoSeconds();
+        uint32_t size = packet->GetSize();
+        m_totalBytes += size;
+        if (now >= m_warmupEndNs)
+        {
+            m_steadyBytes += size;
+        }
+        if (now >= m_startNs)
+        {
+            std::size_t bin = (now - m_startNs) / m_binNs;
+            if (bin < m_bins.size())
+            {
+                m_bins[bin] += size;
+            }
+        }
+    }
+
+    static double GetRate(uint64_t bytes, int64_t durationNs)
+    {
+        return durationNs > 0 ? bytes * 8e3 / durationNs : 0;
+    }
+
+    int64_t m_startNs;
+    int64_t m_binNs;
+    int64_t m_warmupEndNs;
+    int64_t m_endNs;
+    uint64_t m_totalBytes{0};
+    uint64_t m_steadyBytes{0};
+    std::vector<uint64_t> m_bins;
+};
+
+#endif /* GOODPUT_SAMPLER_H */
@@ -0,0 +1,409 @@
+#ifndef PCAP_CAPTURE_H
+#define PCAP_CAPTURE_H
+
+// Packet capture of point-to-point devices for long runs, in place of
+// PointToPointHelper::EnablePcapAll().
+//
+// The files are classic pcap (DLT_PPP, microsecond timestamps), readable by
+// tcpdump, Wireshark and libpcap. By default every packet is kept whole in
+// one uncompressed <prefix>-<node>-<device>.pcap, as with EnablePcapAll(), and
+// the files are written on a background thread. Optionally
+//   - only the first snapLength bytes of a packet are kept (96 holds the PPP,
+//     IPv4 and TCP headers with options),
+//   - only every sampleEvery-th packet of a device is kept, and only during
+//     the first captureFor of the capture (0 = until the end),
+//   - a file is closed and the next one started after rotateBytes bytes or
+//     rotateInterval of simulated time, as <prefix>-<node>-<device>.<n>.pcap,
+//   - the files are compressed by gzip or zstd, which must be installed, as
+//     .pcap.gz or .pcap.zst (Wireshark reads both directly).
+// Failing to write or compress a file aborts the run.
+// The simulator thread only copies the kept bytes into a buffer; it waits for
+// the output thread only when more than maxPendingBytes are not written yet.
+//
+//   PcapCaptureConfig config;
+//   config.rotateBytes = 100 << 20;
+//   PcapCapture capture(config);
+//   capture.InstallAll(dir + "pcap/ns-3");
+//   capture.CloseOnDestroy();
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PcapCaptureConfig
+{
+    uint32_t snapLength{65535};            // bytes kept per packet
+    uint32_t sampleEvery{1};               // keep 1 in this many packets of a device
+    ns3::Time captureFor;                  // from the start of the capture; 0 = whole run
+    uint64_t rotateBytes{0};               // start a new file after this many bytes; 0 = never
+    ns3::Time rotateInterval;              // start a new file after this time; 0 = never
+    std::string compression{"none"};       // none, gzip or zstd
+    std::size_t maxPendingBytes{64 << 20}; // not written yet before the simulator waits
+};
+
+class PcapCapture
+{
+  public:
+    explicit PcapCapture(const PcapCaptureConfig& config)
+        : m_config(config),
+          m_start(ns3::Simulator::Now())
+    {
+        NS_ABORT_MSG_UNLESS(config.compression == "none" || config.compression == "gzip" ||
+                                config.compression == "zstd",
+                            "Unknown pcap compression " << config.compression);
+        NS_ABORT_MSG_UNLESS(config.snapLength > 0 && config.sampleEvery > 0,
+                            "The snap length and sampling must be positive");
+        // popen() succeeds even without the compressor; only writing fails
+        if (config.compression != "none")
+        {
+            std::string command = "command -v " + config.compression + " > /dev/null 2>&1";
+            NS_ABORT_MSG_UNLESS(std::system(command.c_str()) == 0,
+                                "pcap compression needs " << config.compression
+                                                          << ", which is not installed");
+        }
+    }
+
+    ~PcapCapture()
+    {
+        Close();
+    }
+
+    // Capture every point-to-point device of every node
+    void InstallAll(const std::string& prefix)
+    {
+        for (uint32_t n = 0; n < ns3::NodeList::GetNNodes(); ++n)
+        {
+            ns3::Ptr<ns3::Node> node = ns3::NodeList::GetNode(n);
+            for (uint32_t i = 0; i < node->GetNDevices(); ++i)
+            {
+                ns3::Ptr<ns3::NetDevice> device = node->GetDevice(i);
+                if (ns3::DynamicCast<ns3::PointToPointNetDevice>(device))
+                {
+                    Install(device, prefix);
+                }
+            }
+        }
+    }
+
+    // Capture everything device sends and receives, like a promiscuous pcap
+    // of PointToPointHelper
+    void Install(ns3::Ptr<ns3::NetDevice> device, const std::string& prefix)
+    {
+        m_streams.push_back(std::make_unique<Stream>());
+        Stream* stream = m_streams.back().get();
+        stream->capture = this;
+        stream->basePath = prefix + "-" + std::to_string(device->GetNode()->GetId()) + "-" +
+                           std::to_string(device->GetIfIndex());
+        stream->fileStart = m_start;
+        device->TraceConnectWithoutContext("PromiscSniffer",
+                                           ns3::MakeBoundCallback(&PcapCapture::Sniff, stream));
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread(&PcapCapture::Run, this);
+        }
+    }
+
+    // Write out and close every file, then stop the thread
+    void Close()
+    {
+        if (!m_thread.joinable())
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const std::unique_ptr<Stream>& stream : m_streams)
+            {
+                Submit(stream.get(), false);
+            }
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    // Close() as part of Simulator::Destroy()
+    void CloseOnDestroy()
+    {
+        ns3::Simulator::ScheduleDestroy(&PcapCapture::Close, this);
+    }
+
+    uint64_t GetCapturedPackets() const
+    {
+        return m_captured;
+    }
+
+    // Number of times the simulator waited for the output thread
+    uint64_t GetStalls() const
+    {
+        return m_stalls;
+    }
+
+  private:
+    static constexpr std::size_t CHUNK_SIZE = 1 << 16;
+    static constexpr uint32_t DLT_PPP = 9;
+    static constexpr uint64_t PCAP_HEADER_SIZE = 24;
+
+    struct Stream
+    {
+        PcapCapture* capture;
+        std::string basePath;
+        uint64_t seen{0};
+        uint32_t fileIndex{0};
+        bool fileOpen{false};
+        uint64_t fileBytes{0};
+        ns3::Time fileStart;
+        std::vector<uint8_t> chunk; // records not handed to the output thread yet
+        // Output thread only
+        FILE* file{nullptr};
+        std::string path;
+        bool piped{false};
+    };
+
+    // Bytes of one stream for the output thread, to go to a new file if
+    // newFile
+    struct Chunk
+    {
+        Stream* stream;
+        bool newFile;
+        uint32_t fileIndex;
+        std::vector<uint8_t> bytes;
+    };
+
+    static void Sniff(Stream* stream, ns3::Ptr<const ns3::Packet> packet)
+    {
+        PcapCapture* capture = stream->capture;
+        const PcapCaptureConfig& config = capture->m_config;
+        ns3::Time now = ns3::Simulator::Now();
+        if (config.captureFor.IsStrictlyPositive() && now - capture->m_start >= config.captureFor)
+        {
+            return;
+        }
+        if (stream->seen++ % config.sampleEvery != 0)
+        {
+            return;
+        }
+
+        uint32_t size = packet->GetSize();
+        uint32_t length = std::min(size, config.snapLength);
+        bool rotate =
+            (config.rotateBytes > 0 && stream->fileBytes + 16 + length > config.rotateBytes) ||
+            (config.rotateInterval.IsStrictlyPositive() &&
+             now - stream->fileStart >= config.rotateInterval);
+        if (!stream->fileOpen || (rotate && stream->fileBytes > PCAP_HEADER_SIZE))
+        {
+            capture->StartFile(stream, now);
+        }
+        else if (rotate)
+        {
+            // Nothing captured in the last interval: keep the empty file
+            capture->AlignFileStart(stream, now);
+        }
+
+        // Record header and the first length bytes
+        int64_t us = now.GetMicroSeconds();
+        uint32_t header[4] = {static_cast<uint32_t>(us / 1000000),
+                              static_cast<uint32_t>(us % 1000000),
+                              length,
+                              size};
+        std::vector<uint8_t>& chunk = stream->chunk;
+        std::size_t offset = chunk.size();
+        chunk.resize(offset + sizeof(header) + length);
+        std::memcpy(chunk.data() + offset, header, sizeof(header));
+        packet->CopyData(chunk.data() + offset + sizeof(header), length);
+        stream->fileBytes += sizeof(header) + length;
+        capture->m_captured++;
+        if (chunk.size() >= CHUNK_SIZE)
+        {
+            capture->Hand(stream, false);
+        }
+    }
+
+    // Hand the records so far to the old file and start the next one with
+    // its global header
+    void StartFile(Stream* stream, ns3::Time now)
+    {
+        if (stream->fileOpen)
+        {
+            Hand(stream, false);
+            stream->fileIndex++;
+        }
+        stream->fileOpen = true;
+        AlignFileStart(stream, now);
+        // Magic, version 2.4, UTC, timestamp accuracy, snap length, link type
+        uint32_t header[6] = {0xa1b2c3d4, 0x00040002, 0, 0, m_config.snapLength, DLT_PPP};
+        stream->chunk.assign(reinterpret_cast<uint8_t*>(header),
+                             reinterpret_cast<uint8_t*>(header) + sizeof(header));
+        stream->fileBytes = PCAP_HEADER_SIZE;
+        Hand(stream, true);
+    }
+
+    // Files rotated by time cover whole intervals from the start of the capture
+    void AlignFileStart(Stream* stream, ns3::Time now)
+    {
+        if (m_config.rotateInterval.IsStrictlyPositive())
+        {
+            int64_t intervals =
+                (now - m_start).GetTimeStep() / m_config.rotateInterval.GetTimeStep();
+            stream->fileStart = m_start + m_config.rotateInterval * intervals;
+        }
+    }
+
+    // Pass the records of stream to the output thread
+    void Hand(Stream* stream, bool newFile)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_pendingBytes > m_config.maxPendingBytes)
+        {
+            m_stalls++;
+            m_wake.notify_one();
+            m_drained.wait(lock, [this] { return m_pendingBytes <= m_config.maxPendingBytes; });
+        }
+        Submit(stream, newFile);
+        lock.unlock();
+        m_wake.notify_one();
+    }
+
+    // With m_mutex held
+    void Submit(Stream* stream, bool newFile)
+    {
+        if (stream->chunk.empty() && !newFile)
+        {
+            return;
+        }
+        m_pendingBytes += stream->chunk.size();
+        m_pending.push_back({stream, newFile, stream->fileIndex, std::move(stream->chunk)});
+        stream->chunk = std::vector<uint8_t>();
+        stream->chunk.reserve(CHUNK_SIZE + 16 + m_config.snapLength);
+    }
+
+    void Run()
+    {
+        // A compressor that exits early must fail the write to its pipe with
+        // EPIPE, not kill the process with SIGPIPE
+        sigset_t pipe;
+        sigemptyset(&pipe);
+        sigaddset(&pipe, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+            if (m_pending.empty() && m_stop)
+            {
+                break;
+            }
+            std::deque<Chunk> batch;
+            batch.swap(m_pending);
+            std::size_t bytes = m_pendingBytes;
+            lock.unlock();
+            for (Chunk& chunk : batch)
+            {
+                Write(chunk);
+            }
+            lock.lock();
+            m_pendingBytes -= bytes;
+            m_drained.notify_all();
+        }
+        lock.unlock();
+        for (const std::unique_ptr<Stream>& stream : m_streams)
+        {
+            CloseFile(stream.get());
+        }
+    }
+
+    // Output thread
+    void Write(Chunk& chunk)
+    {
+        Stream* stream = chunk.stream;
+        if (chunk.newFile)
+        {
+            CloseFile(stream);
+            OpenFile(stream, chunk.fileIndex);
+        }
+        if (stream->file && !chunk.bytes.empty())
+        {
+            std::size_t written =
+                std::fwrite(chunk.bytes.data(), 1, chunk.bytes.size(), stream->file);
+            NS_ABORT_MSG_UNLESS(written == chunk.bytes.size(), "Cannot write " << stream->path);
+        }
+    }
+
+    void OpenFile(Stream* stream, uint32_t index)
+    {
+        bool rotating =
+            m_config.rotateBytes > 0 || m_config.rotateInterval.IsStrictlyPositive();
+        std::string path =
+            stream->basePath + (rotating ? "." + std::to_string(index) : "") + ".pcap";
+        if (m_config.compression == "none")
+        {
+            stream->file = std::fopen(path.c_str(), "wb");
+            stream->piped = false;
+        }
+        else
+        {
+            bool gzip = m_config.compression == "gzip";
+            path += gzip ? ".gz" : ".zst";
+            std::string command = (gzip ? "gzip -1 -c > " : "zstd -1 -q -c > ") + Quote(path);
+            stream->file = popen(command.c_str(), "w");
+            stream->piped = true;
+        }
+        NS_ABORT_MSG_UNLESS(stream->file, "Cannot write " << path);
+        stream->path = path;
+    }
+
+    // path as a single word of a shell command
+    static std::string Quote(const std::string& path)
+    {
+        std::string quoted = "'";
+        for (char c : path)
+        {
+            quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        return quoted + "'";
+    }
+
+    void CloseFile(Stream* stream)
+    {
+        if (!stream->file)
+        {
+            return;
+        }
+        // pclose() returns the exit status of the compressor
+        int status = stream->piped ? pclose(stream->file) : std::fclose(stream->file);
+        stream->file = nullptr;
+        NS_ABORT_MSG_UNLESS(status == 0, "Cannot write " << stream->path);
+    }
+
+    PcapCaptureConfig m_config;
+    ns3::Time m_start;
+    std::vector<std::unique_ptr<Stream>> m_streams;
+    uint64_t m_captured{0};
+    uint64_t m_stalls{0};
+
+    std::thread m_thread;
+    std::mutex m_mutex; // guards m_pending, m_pendingBytes and m_stop
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+    std::deque<Chunk> m_pending;
+    std::size_t m_pendingBytes{0};
+    bool m_stop{false};
+};
+
+#endif /* PCAP_CAPTURE_H */
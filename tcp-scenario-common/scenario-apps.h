@@ -0,0 +1,107 @@
+#ifndef SCENARIO_APPS_H
+#define SCENARIO_APPS_H
+
+// Traffic of the scenarios: BulkSend and OnOff senders and PacketSink
+// receivers. Every flow starts at 1 s, staggered by its index.
+
+#include "flow-observer.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <string>
+#include <vector>
+
+//Sender side
+// Function to install BulkSend application. Flow i goes to port + i and starts
+// i * stagger after the first one, plus a random delay of up to jitter. Every
+// flow is handed to the observers (cwnd tracing, endpoint accounting).
+inline void
+InstallBulkSend(ns3::Ptr<ns3::Node> node,
+                ns3::Ipv4Address address,
+                uint16_t port,
+                std::string socketFactory,
+                ns3::Time stopTime,
+                uint16_t num_flows = 1,
+                const std::vector<FlowObserver*>& observers = {},
+                ns3::Time stagger = ns3::Seconds(0.1),
+                ns3::Time jitter = ns3::Seconds(0))
+{
+    ns3::Ptr<ns3::UniformRandomVariable> jitterRng =
+        ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint16_t i = 0; i < num_flows; ++i)
+    {
+        ns3::BulkSendHelper source(socketFactory, ns3::InetSocketAddress(address, port + i));
+        source.SetAttribute("MaxBytes", ns3::UintegerValue(0));
+        ns3::ApplicationContainer sourceApps = source.Install(node);
+        ns3::Time start = ns3::Seconds(1.0) + stagger * static_cast<int64_t>(i);
+        if (jitter.IsStrictlyPositive())
+        {
+            start += ns3::Seconds(jitterRng->GetValue(0, jitter.GetSeconds()));
+        }
+        sourceApps.Start(start); // Stagger the start times slightly
+        for (FlowObserver* observer : observers)
+        {
+            observer->Add(ns3::DynamicCast<ns3::BulkSendApplication>(sourceApps.Get(0)),
+                          start,
+                          port + i);
+        }
+        // Ensure stopTime is set appropriately and staggered
+        sourceApps.Stop(stopTime + stagger * static_cast<int64_t>(i));
+    }
+}
+
+// Function to install OnOff applications sending packetSize packets at
+// dataRate to port ... port + num_flows - 1; the default size fills one
+// segment of the scenarios, unlike OnOffApplication's own 512 bytes
+inline void
+InstallOnOff(ns3::Ptr<ns3::Node> node,
+             ns3::Ipv4Address address,
+             uint16_t port,
+             std::string socketFactory,
+             ns3::DataRate dataRate,
+             ns3::Time stopTime,
+             uint16_t num_flows = 1,
+             uint32_t packetSize = 1448)
+{
+    for (uint16_t i = 0; i < num_flows; ++i)
+    {
+        // Configure the OnOff application to send traffic to the specified address and port
+        ns3::OnOffHelper onOffHelper(socketFactory, ns3::InetSocketAddress(address, port + i));
+        onOffHelper.SetAttribute("DataRate", ns3::DataRateValue(dataRate));
+        onOffHelper.SetAttribute("PacketSize", ns3::UintegerValue(packetSize));
+        onOffHelper.SetAttribute("OnTime",
+                                 ns3::StringValue("ns3::ConstantRandomVariable[Constant=1]"));
+        onOffHelper.SetAttribute("OffTime",
+                                 ns3::StringValue("ns3::ConstantRandomVariable[Constant=0]"));
+
+        // Install the OnOff application on the specified node
+        ns3::ApplicationContainer sourceApps = onOffHelper.Install(node);
+        sourceApps.Start(ns3::Seconds(1.0 + i * 0.1)); // Stagger start times slightly
+        sourceApps.Stop(stopTime + ns3::Seconds(i * 0.1)); // Stagger stop times appropriately
+    }
+}
+
+//Receiver side
+// Function to install sink applications on ports port ... port + num_flows - 1
+inline ns3::ApplicationContainer
+InstallPacketSink(ns3::Ptr<ns3::Node> node,
+                  uint16_t port,
+                  std::string socketFactory,
+                  ns3::Time stopTime,
+                  uint16_t num_flows = 1)
+{
+    ns3::ApplicationContainer sinkApps;
+    for (uint16_t i = 0; i < num_flows; ++i)
+    {
+        ns3::PacketSinkHelper sink(socketFactory,
+                                   ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), port + i));
+        sinkApps.Add(sink.Install(node));
+    }
+    sinkApps.Start(ns3::Seconds(1.0));
+    sinkApps.Stop(stopTime);
+    return sinkApps;
+}
+
+#endif /* SCENARIO_APPS_H */
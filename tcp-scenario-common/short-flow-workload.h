@@ -0,0 +1,521 @@
+#ifndef SHORT_FLOW_WORKLOAD_H
+#define SHORT_FLOW_WORKLOAD_H
+
+// Web-like traffic next to the long flows of a scenario: finite TCP flows
+// with sizes drawn from an empirical distribution, arriving as a Poisson
+// process at a target load of the bottleneck, and their flow completion
+// times (FCT) by flow size.
+//
+// Flows are not ns-3 applications and do not open connections of their own.
+// Every sender keeps a fixed pool of persistent connections to its receiver,
+// opened when the workload is installed, and a flow is a request carried
+// over an idle one: its bytes are written to the socket and the flow is
+// complete once the receiver has acknowledged the last of them, after which
+// the connection takes the next request. Requests that find every
+// connection of their sender busy wait in arrival order, like a browser
+// with a limit of connections per host. No socket is ever closed, so the
+// number of sockets stays at two per connection plus one listening socket
+// per receiver however many flows there are, and none is left in TIME_WAIT.
+//
+// The FCT of a flow is from the request until its last byte is
+// acknowledged. It is reported split in two as well: the wait for a free
+// connection, and the transfer from the moment the request was written to
+// the connection. Flows still running or waiting at the end are counted as
+// unfinished.
+//
+// Only the first flow of a connection goes through the handshake. With
+// slowStart, every later one starts from the initial window again, as on a
+// new connection or after an idle period in Linux (tcp_slow_start_after_idle):
+// the congestion window of the idle connection is cut to the initial window
+// and ssthresh kept at no less than 3/4 of the old window. Without it, a flow
+// inherits the window its connection had at the end of the previous one.
+// Either way, a model such as BBR keeps the path estimates of earlier flows.
+//
+//   ShortFlowWorkload workload(GetWebSearchFlowSizes(), 40000, 8, true);
+//   workload.Install(senders, receivers, receiverAddresses, 0.5, bottleneckRate,
+//                    Seconds(1.0), stopTime);
+//   ...
+//   workload.Print(resultFile);
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// (bytes, cumulative probability) points of a flow size distribution, sizes
+// linearly interpolated between them
+using FlowSizeCdf = std::vector<std::pair<double, double>>;
+
+// Web search workload of the DCTCP paper (as used by pFabric and later
+// studies): most flows are a few packets, most bytes are in flows of MBs
+inline FlowSizeCdf
+GetWebSearchFlowSizes()
+{
+    static const double packets[][2] = {{6, 0},
+                                        {6, 0.15},
+                                        {13, 0.2},
+                                        {19, 0.3},
+                                        {33, 0.4},
+                                        {53, 0.53},
+                                        {133, 0.6},
+                                        {667, 0.7},
+                                        {1333, 0.8},
+                                        {3333, 0.9},
+                                        {6667, 0.97},
+                                        {20000, 1}};
+    FlowSizeCdf cdf;
+    for (const auto& point : packets)
+    {
+        cdf.emplace_back(point[0] * 1460, point[1]);
+    }
+    return cdf;
+}
+
+// Read "bytes probability" lines, e.g. for --flowSizeCdf. Lines starting with
+// # are comments.
+inline FlowSizeCdf
+ReadFlowSizeCdf(const std::string& file)
+{
+    std::ifstream in(file);
+    NS_ABORT_MSG_UNLESS(in.is_open(), "Cannot open flow size distribution " << file);
+    FlowSizeCdf cdf;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        double bytes;
+        double probability;
+        if (line.empty() || line[0] == '#' || !(fields >> bytes >> probability))
+        {
+            continue;
+        }
+        NS_ABORT_MSG_UNLESS(cdf.empty() || (bytes >= cdf.back().first &&
+                                            probability > cdf.back().second),
+                            "Flow sizes and probabilities must increase in " << file);
+        cdf.emplace_back(bytes, probability);
+    }
+    NS_ABORT_MSG_UNLESS(!cdf.empty() && cdf.back().second == 1,
+                        "The flow size distribution in " << file << " must end at probability 1");
+    return cdf;
+}
+
+// Mean bytes of a flow
+inline double
+GetMeanFlowSize(const FlowSizeCdf& cdf)
+{
+    double mean = cdf.front().first * cdf.front().second;
+    for (std::size_t i = 1; i < cdf.size(); ++i)
+    {
+        mean += (cdf[i - 1].first + cdf[i].first) / 2 * (cdf[i].second - cdf[i - 1].second);
+    }
+    return mean;
+}
+
+class ShortFlowWorkload
+{
+  public:
+    // connections is the size of the connection pool of every sender;
+    // slowStart restarts the window of a connection for every flow
+    ShortFlowWorkload(const FlowSizeCdf& sizes,
+                      uint16_t port,
+                      uint32_t connections,
+                      bool slowStart)
+        : m_port(port),
+          m_connectionsPerSender(connections),
+          m_slowStart(slowStart),
+          m_meanSize(GetMeanFlowSize(sizes))
+    {
+        NS_ABORT_MSG_UNLESS(connections > 0, "Short flows need at least one connection");
+        m_sizes = ns3::CreateObject<ns3::EmpiricalRandomVariable>();
+        m_sizes->SetInterpolate(true);
+        for (const auto& [bytes, probability] : sizes)
+        {
+            m_sizes->CDF(bytes, probability);
+        }
+        m_arrivals = ns3::CreateObject<ns3::ExponentialRandomVariable>();
+        m_senderChoice = ns3::CreateObject<ns3::UniformRandomVariable>();
+    }
+
+    // Open the connection pools now and start flows from start until stop at
+    // load (a fraction of rate, in payload bytes) from a random sender to
+    // receiver i % receivers
+    void Install(ns3::NodeContainer senders,
+                 ns3::NodeContainer receivers,
+                 const std::vector<ns3::Ipv4Address>& receiverAddresses,
+                 double load,
+                 ns3::DataRate rate,
+                 ns3::Time start,
+                 ns3::Time stop)
+    {
+        NS_ABORT_MSG_UNLESS(load > 0 && senders.GetN() > 0 &&
+                                receiverAddresses.size() == receivers.GetN(),
+                            "Short flows need a positive load, senders and receivers");
+        m_senders = senders;
+        m_receiverAddresses = receiverAddresses;
+        for (uint32_t i = 0; i < receivers.GetN(); ++i)
+        {
+            ns3::Ptr<ns3::Socket> socket =
+                ns3::Socket::CreateSocket(receivers.Get(i), ns3::TcpSocketFactory::GetTypeId());
+            socket->Bind(ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), m_port));
+            socket->Listen();
+            socket->SetAcceptCallback(
+                ns3::MakeNullCallback<bool, ns3::Ptr<ns3::Socket>, const ns3::Address&>(),
+                ns3::MakeCallback(&ShortFlowWorkload::Accept, this));
+            m_listeners.push_back(socket);
+        }
+        m_idle.resize(senders.GetN());
+        m_waiting.resize(senders.GetN());
+        for (uint32_t i = 0; i < senders.GetN(); ++i)
+        {
+            for (uint32_t c = 0; c < m_connectionsPerSender; ++c)
+            {
+                m_connections.push_back(Connection());
+                m_connections.back().workload = this;
+                m_connections.back().sender = i;
+                Open(&m_connections.back());
+            }
+        }
+
+        m_load = load;
+        m_arrivalRate = load * rate.GetBitRate() / 8 / m_meanSize;
+        m_arrivals->SetAttribute("Mean", ns3::DoubleValue(1 / m_arrivalRate));
+        m_stop = stop;
+        ns3::Simulator::Schedule(start - ns3::Simulator::Now() +
+                                     ns3::Seconds(m_arrivals->GetValue()),
+                                 &ShortFlowWorkload::Arrive,
+                                 this);
+    }
+
+    uint64_t GetStartedFlows() const
+    {
+        return m_started;
+    }
+
+    uint64_t GetCompletedFlows() const
+    {
+        return m_completed.size();
+    }
+
+    // Flows started and not completed
+    uint64_t GetUnfinishedFlows() const
+    {
+        return m_started - m_completed.size();
+    }
+
+    // Persistent connections of all senders; each has a socket at both ends
+    std::size_t GetConnectionCount() const
+    {
+        return m_connections.size();
+    }
+
+    // Connection attempts, including those reopened after a failure
+    uint64_t GetConnectionAttempts() const
+    {
+        return m_attempts;
+    }
+
+    // Summary for goodput_retransmission_results.txt: counts, and for the
+    // flows of every size bucket the mean, p50, p95 and p99 FCT in ms, the
+    // p50, p95 and p99 of the transfer alone, and the mean and p99 wait
+    void Print(std::ostream& os) const
+    {
+        os << "Short flows: " << m_started << " started, " << m_completed.size()
+           << " completed, " << GetUnfinishedFlows() << " unfinished, load " << m_load
+           << ", mean size " << m_meanSize << " bytes, " << m_arrivalRate << " flows/s over "
+           << m_connections.size() << " persistent connections (" << m_attempts
+           << " connection attempts), " << (m_slowStart ? "slow start" : "no slow start")
+           << " per flow\n";
+        static const double bounds[] = {1e4, 1e5, 1e6};
+        static const char* names[] = {"<=10KB", "10KB-100KB", "100KB-1MB", ">1MB"};
+        std::vector<double> fcts[4];
+        std::vector<double> transfers[4];
+        std::vector<double> waits[4];
+        for (const Completed& flow : m_completed)
+        {
+            std::size_t bucket = std::upper_bound(bounds, bounds + 3, flow.size - 0.5) - bounds;
+            fcts[bucket].push_back((flow.wait + flow.transfer).GetSeconds() * 1e3);
+            transfers[bucket].push_back(flow.transfer.GetSeconds() * 1e3);
+            waits[bucket].push_back(flow.wait.GetSeconds() * 1e3);
+        }
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            std::vector<double>& fct = fcts[i];
+            os << "  FCT " << names[i] << ": " << fct.size() << " flows";
+            if (!fct.empty())
+            {
+                std::vector<double>& transfer = transfers[i];
+                std::vector<double>& wait = waits[i];
+                std::sort(fct.begin(), fct.end());
+                std::sort(transfer.begin(), transfer.end());
+                std::sort(wait.begin(), wait.end());
+                os << ", mean " << GetMean(fct) << " ms, p50/p95/p99 " << GetPercentile(fct, 0.5)
+                   << " " << GetPercentile(fct, 0.95) << " " << GetPercentile(fct, 0.99)
+                   << " ms; transfer p50/p95/p99 " << GetPercentile(transfer, 0.5) << " "
+                   << GetPercentile(transfer, 0.95) << " " << GetPercentile(transfer, 0.99)
+                   << " ms; wait mean " << GetMean(wait) << " ms, p99 "
+                   << GetPercentile(wait, 0.99) << " ms";
+            }
+            os << "\n";
+        }
+    }
+
+    // One line per completed flow: request time (s), size (bytes), FCT (s),
+    // and the wait (s) and transfer (s) that make up the FCT
+    void Write(std::ostream& os) const
+    {
+        for (const Completed& flow : m_completed)
+        {
+            os << flow.start.GetSeconds() << " " << flow.size << " "
+               << (flow.wait + flow.transfer).GetSeconds() << " " << flow.wait.GetSeconds() << " "
+               << flow.transfer.GetSeconds() << "\n";
+        }
+    }
+
+  private:
+    struct Request
+    {
+        ns3::Time start;
+        uint64_t size;
+        ns3::Time dispatched; // written to a connection
+    };
+
+    // A persistent connection of a sender and the request it carries
+    struct Connection
+    {
+        ShortFlowWorkload* workload;
+        uint32_t sender;
+        ns3::Ptr<ns3::Socket> socket;
+        bool busy{false};
+        Request request;
+        uint64_t queued{0};             // bytes of the request written to the socket
+        bool lastQueued{false};         // all of them, ending at lastByte
+        ns3::SequenceNumber32 lastByte; // sequence number after the request
+    };
+
+    struct Completed
+    {
+        ns3::Time start;
+        uint64_t size;
+        ns3::Time wait;     // for a free connection
+        ns3::Time transfer; // from the dispatch until the last byte was acknowledged
+    };
+
+    // Access to the congestion state of a socket, which TcpSocketBase keeps
+    // to itself
+    struct TcpStateAccess : public ns3::TcpSocketBase
+    {
+        static ns3::Ptr<ns3::TcpSocketState> Get(ns3::Ptr<ns3::TcpSocketBase> socket)
+        {
+            return PeekPointer(socket)->*(&TcpStateAccess::m_tcb);
+        }
+    };
+
+    static double GetMean(const std::vector<double>& values)
+    {
+        double sum = 0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        return sum / values.size();
+    }
+
+    // Nearest-rank percentile of sorted values
+    static double GetPercentile(const std::vector<double>& sorted, double p)
+    {
+        std::size_t rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+    void Open(Connection* connection)
+    {
+        m_attempts++;
+        connection->socket = ns3::Socket::CreateSocket(m_senders.Get(connection->sender),
+                                                       ns3::TcpSocketFactory::GetTypeId());
+        connection->socket->Bind();
+        connection->socket->SetConnectCallback(
+            ns3::MakeBoundCallback(&ShortFlowWorkload::Connected, connection),
+            ns3::MakeBoundCallback(&ShortFlowWorkload::ConnectionFailed, connection));
+        connection->socket->SetSendCallback(
+            ns3::MakeBoundCallback(&ShortFlowWorkload::SendMore, connection));
+        connection->socket->TraceConnectWithoutContext(
+            "HighestRxAck",
+            ns3::MakeBoundCallback(&ShortFlowWorkload::Acked, connection));
+        uint32_t receiver = connection->sender % m_receiverAddresses.size();
+        connection->socket->Connect(
+            ns3::InetSocketAddress(m_receiverAddresses[receiver], m_port));
+    }
+
+    void Arrive()
+    {
+        if (ns3::Simulator::Now() >= m_stop)
+        {
+            return;
+        }
+        uint32_t sender = m_senderChoice->GetInteger(0, m_senders.GetN() - 1);
+        uint64_t size = std::max<uint64_t>(std::llround(m_sizes->GetValue()), 1);
+        m_waiting[sender].push_back({ns3::Simulator::Now(), size, ns3::Time()});
+        m_started++;
+        Dispatch(sender);
+        ns3::Simulator::Schedule(ns3::Seconds(m_arrivals->GetValue()),
+                                 &ShortFlowWorkload::Arrive,
+                                 this);
+    }
+
+    // Hand waiting requests of sender to its idle connections
+    void Dispatch(uint32_t sender)
+    {
+        while (!m_waiting[sender].empty() && !m_idle[sender].empty())
+        {
+            Connection* connection = m_idle[sender].back();
+            m_idle[sender].pop_back();
+            connection->busy = true;
+            connection->request = m_waiting[sender].front();
+            connection->request.dispatched = ns3::Simulator::Now();
+            connection->queued = 0;
+            connection->lastQueued = false;
+            m_waiting[sender].pop_front();
+            if (m_slowStart)
+            {
+                RestartWindow(connection);
+            }
+            Send(connection);
+        }
+    }
+
+    static void Connected(Connection* connection, ns3::Ptr<ns3::Socket> socket)
+    {
+        ShortFlowWorkload* workload = connection->workload;
+        workload->m_idle[connection->sender].push_back(connection);
+        workload->Dispatch(connection->sender);
+    }
+
+    // Only before the connection was established, so it carries no request
+    static void ConnectionFailed(Connection* connection, ns3::Ptr<ns3::Socket> socket)
+    {
+        ns3::Simulator::Schedule(ns3::Seconds(1),
+                                 &ShortFlowWorkload::Open,
+                                 connection->workload,
+                                 connection);
+    }
+
+    static void SendMore(Connection* connection, ns3::Ptr<ns3::Socket> socket, uint32_t available)
+    {
+        if (connection->busy && !connection->lastQueued)
+        {
+            Send(connection);
+        }
+    }
+
+    // Cut the window of an idle connection back to the initial window, like
+    // tcp_cwnd_restart() of Linux, unless it is recovering from a loss
+    static void RestartWindow(Connection* connection)
+    {
+        ns3::Ptr<ns3::TcpSocketState> tcb =
+            TcpStateAccess::Get(ns3::DynamicCast<ns3::TcpSocketBase>(connection->socket));
+        uint32_t window = tcb->m_initialCWnd * tcb->m_segmentSize;
+        uint32_t cwnd = tcb->m_cWnd;
+        if (tcb->m_congState.Get() != ns3::TcpSocketState::CA_OPEN || cwnd <= window)
+        {
+            return;
+        }
+        tcb->m_ssThresh = std::max<uint32_t>(tcb->m_ssThresh, cwnd / 4 * 3);
+        tcb->m_cWnd = window;
+        tcb->m_cWndInfl = window;
+    }
+
+    // As much of the request as the send buffer takes
+    static void Send(Connection* connection)
+    {
+        Request& request = connection->request;
+        while (connection->queued < request.size)
+        {
+            uint32_t bytes = std::min<uint64_t>(request.size - connection->queued,
+                                                connection->socket->GetTxAvailable());
+            int sent =
+                bytes > 0 ? connection->socket->Send(ns3::Create<ns3::Packet>(bytes)) : 0;
+            if (sent <= 0)
+            {
+                return;
+            }
+            connection->queued += sent;
+        }
+        ns3::Ptr<ns3::TcpSocketBase> tcp =
+            ns3::DynamicCast<ns3::TcpSocketBase>(connection->socket);
+        connection->lastByte = tcp->GetTxBuffer()->TailSequence();
+        connection->lastQueued = true;
+    }
+
+    static void Acked(Connection* connection,
+                      ns3::SequenceNumber32 oldAck,
+                      ns3::SequenceNumber32 newAck)
+    {
+        if (connection->busy && connection->lastQueued && newAck >= connection->lastByte)
+        {
+            // Not while the socket is still processing the ACK
+            connection->busy = false;
+            ns3::Simulator::ScheduleNow(&ShortFlowWorkload::Complete,
+                                        connection->workload,
+                                        connection);
+        }
+    }
+
+    void Complete(Connection* connection)
+    {
+        const Request& request = connection->request;
+        m_completed.push_back({request.start,
+                               request.size,
+                               request.dispatched - request.start,
+                               ns3::Simulator::Now() - request.dispatched});
+        m_idle[connection->sender].push_back(connection);
+        Dispatch(connection->sender);
+    }
+
+    // The receiving end of a connection only drains what arrives
+    void Accept(ns3::Ptr<ns3::Socket> socket, const ns3::Address& from)
+    {
+        socket->SetRecvCallback(ns3::MakeCallback(&ShortFlowWorkload::Drain));
+        m_accepted.push_back(socket);
+    }
+
+    static void Drain(ns3::Ptr<ns3::Socket> socket)
+    {
+        while (socket->Recv())
+        {
+        }
+    }
+
+    uint16_t m_port;
+    uint32_t m_connectionsPerSender;
+    bool m_slowStart;
+    double m_meanSize;
+    double m_load{0};
+    double m_arrivalRate{0}; // flows/s
+    ns3::Time m_stop;
+    ns3::Ptr<ns3::EmpiricalRandomVariable> m_sizes;
+    ns3::Ptr<ns3::ExponentialRandomVariable> m_arrivals;
+    ns3::Ptr<ns3::UniformRandomVariable> m_senderChoice;
+
+    ns3::NodeContainer m_senders;
+    std::vector<ns3::Ipv4Address> m_receiverAddresses;
+    std::vector<ns3::Ptr<ns3::Socket>> m_listeners;
+    std::vector<ns3::Ptr<ns3::Socket>> m_accepted;
+
+    std::deque<Connection> m_connections;         // a deque keeps them in place
+    std::vector<std::vector<Connection*>> m_idle; // by sender
+    std::vector<std::deque<Request>> m_waiting;   // by sender, oldest first
+    std::vector<Completed> m_completed;
+    uint64_t m_started{0};
+    uint64_t m_attempts{0};
+};
+
+#endif /* SHORT_FLOW_WORKLOAD_H */
@@ -0,0 +1,110 @@
+#ifndef SOCKET_BUFFER_TRACKER_H
+#define SOCKET_BUFFER_TRACKER_H
+
+// High-water marks of the TCP send and receive buffers of a scenario, to
+// check that buffers sized from the bandwidth-delay product are never the
+// limit and to see how much memory they take.
+//
+// The send buffer of every BulkSend socket is read whenever the socket sends
+// a segment and the receive buffer of every socket accepted by a PacketSink
+// whenever it receives one, which is when out-of-order data accumulates.
+// PacketSink keeps its accept callback to itself, so the socket a sink
+// accepted is hooked on the first data of the sink, after which the sink is
+// no longer traced. Every sink of the scenarios accepts a single flow.
+//
+//   SocketBufferTracker buffers;
+//   buffers.AddSink(sink);
+//   InstallBulkSend(..., {&buffers});
+//   ...
+//   buffers.Print(resultFile);
+
+#include "flow-observer.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <algorithm>
+#include <ostream>
+
+class SocketBufferTracker : public FlowObserver
+{
+  public:
+    void Add(ns3::Ptr<ns3::BulkSendApplication> app, ns3::Time start, uint16_t port) override
+    {
+        ns3::Simulator::Schedule(GetBindDelay(start), &SocketBufferTracker::Bind, this, app);
+    }
+
+    void AddSink(ns3::Ptr<ns3::PacketSink> sink)
+    {
+        sink->TraceConnectWithoutContext(
+            "Rx",
+            ns3::MakeBoundCallback(&SocketBufferTracker::SinkRx, this, sink));
+    }
+
+    // Bytes, over all flows
+    uint32_t GetTxHighWater() const
+    {
+        return m_txHighWater;
+    }
+
+    uint32_t GetRxHighWater() const
+    {
+        return m_rxHighWater;
+    }
+
+    void Print(std::ostream& os) const
+    {
+        os << "Tx buffer high-water: " << m_txHighWater << " bytes\n";
+        os << "Rx buffer high-water: " << m_rxHighWater << " bytes\n";
+    }
+
+  private:
+    void Bind(ns3::Ptr<ns3::BulkSendApplication> app)
+    {
+        app->GetSocket()->TraceConnectWithoutContext(
+            "Tx",
+            ns3::MakeCallback(&SocketBufferTracker::Tx, this));
+    }
+
+    void Tx(ns3::Ptr<const ns3::Packet> packet,
+            const ns3::TcpHeader& header,
+            ns3::Ptr<const ns3::TcpSocketBase> socket)
+    {
+        m_txHighWater = std::max(m_txHighWater, socket->GetTxBuffer()->Size());
+    }
+
+    void Rx(ns3::Ptr<const ns3::Packet> packet,
+            const ns3::TcpHeader& header,
+            ns3::Ptr<const ns3::TcpSocketBase> socket)
+    {
+        m_rxHighWater = std::max(m_rxHighWater, socket->GetRxBuffer()->Size());
+    }
+
+    // First data of sink: its connection has just been accepted
+    static void SinkRx(SocketBufferTracker* tracker,
+                       ns3::Ptr<ns3::PacketSink> sink,
+                       ns3::Ptr<const ns3::Packet> packet,
+                       const ns3::Address& from)
+    {
+        for (ns3::Ptr<ns3::Socket> socket : sink->GetAcceptedSockets())
+        {
+            socket->TraceConnectWithoutContext("Rx",
+                                               ns3::MakeCallback(&SocketBufferTracker::Rx, tracker));
+        }
+        // Not from inside the trace that is being invoked
+        ns3::Simulator::ScheduleNow(&SocketBufferTracker::Unhook, tracker, sink);
+    }
+
+    void Unhook(ns3::Ptr<ns3::PacketSink> sink)
+    {
+        sink->TraceDisconnectWithoutContext(
+            "Rx",
+            ns3::MakeBoundCallback(&SocketBufferTracker::SinkRx, this, sink));
+    }
+
+    uint32_t m_txHighWater{0};
+    uint32_t m_rxHighWater{0};
+};
+
+#endif /* SOCKET_BUFFER_TRACKER_H */
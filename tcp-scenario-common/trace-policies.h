@@ -0,0 +1,359 @@
+#ifndef TRACE_POLICIES_H
+#define TRACE_POLICIES_H
+
+// Tracers of the scenarios as compile-time policies.
+//
+// A scenario holds a ScenarioTracers<Queue, Drop, Cwnd, Pcap, FlowStats> and
+// calls the same hooks on every tracer (Install, AddTo, Finish, Write). Each
+// tracer is either the real one or NoTrace, whose hooks are empty inline
+// templates: a build without a tracer has no trace sink connected, no branch
+// on an option and no file open for it, as the calls compile to nothing.
+//
+// Which tracers are built is chosen when configuring ns-3, without editing
+// the scenarios, e.g. for a build without any instrumentation:
+//
+//   ./ns3 configure -- -DCMAKE_CXX_FLAGS="-DTCP_SCENARIO_TRACE_QUEUE=0
+//       -DTCP_SCENARIO_TRACE_DROP=0 -DTCP_SCENARIO_TRACE_CWND=0 -DTCP_SCENARIO_TRACE_PCAP=0
+//       -DTCP_SCENARIO_FLOW_STATS=0"
+//
+// All of them default to 1. A tracer that is built may still be switched off
+// at run time by the options of the scenario. trace-overhead.sh of
+// tcp-bbr-replication-experiment times the benchmark cells with both builds.
+
+#include "flow-histograms.h"
+#include "flow-observer.h"
+#include "flow-tracer.h"
+#include "pcap-capture.h"
+#include "trace-writer.h"
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef TCP_SCENARIO_TRACE_QUEUE
+#define TCP_SCENARIO_TRACE_QUEUE 1
+#endif
+#ifndef TCP_SCENARIO_TRACE_DROP
+#define TCP_SCENARIO_TRACE_DROP 1
+#endif
+#ifndef TCP_SCENARIO_TRACE_CWND
+#define TCP_SCENARIO_TRACE_CWND 1
+#endif
+#ifndef TCP_SCENARIO_TRACE_PCAP
+#define TCP_SCENARIO_TRACE_PCAP 1
+#endif
+#ifndef TCP_SCENARIO_FLOW_STATS
+#define TCP_SCENARIO_FLOW_STATS 1
+#endif
+
+// Opens the trace basePath with the format and output thread of the scenario:
+// (basePath, name, unit, textSuffix)
+using TraceOpener = std::function<std::unique_ptr<TraceWriter>(const std::string&,
+                                                               const std::string&,
+                                                               const std::string&,
+                                                               const std::string&)>;
+
+// A tracer that is not built
+struct NoTrace
+{
+    static constexpr bool enabled = false;
+
+    template <class... Args>
+    void Install(Args&&...)
+    {
+    }
+
+    template <class... Args>
+    void AddTo(Args&&...)
+    {
+    }
+
+    template <class... Args>
+    void Finish(Args&&...)
+    {
+    }
+
+    template <class... Args>
+    void Write(Args&&...)
+    {
+    }
+};
+
+// Size of the bottleneck queue every interval, in queue-size.dat
+class QueueSizeTrace
+{
+  public:
+    static constexpr bool enabled = true;
+
+    // Sample the queue with a simulator event every interval
+    void Install(const TraceOpener& open,
+                 const std::string& dir,
+                 ns3::Ptr<ns3::QueueDisc> queue,
+                 ns3::Time interval)
+    {
+        Open(open, dir, queue);
+        m_queue = queue;
+        m_interval = interval;
+        ns3::Simulator::ScheduleNow(&QueueSizeTrace::Sample, this);
+    }
+
+    // Let tracker write the samples instead, as it sees the queue change
+    // (QueueOccupancyTracker::EnableSampling)
+    template <class Tracker>
+    void Install(const TraceOpener& open,
+                 const std::string& dir,
+                 ns3::Ptr<ns3::QueueDisc> queue,
+                 ns3::Time interval,
+                 Tracker& tracker)
+    {
+        Open(open, dir, queue);
+        tracker.EnableSampling(m_writer.get(), interval);
+    }
+
+    // After Simulator::Destroy()
+    void Finish()
+    {
+        m_writer.reset();
+    }
+
+  private:
+    void Open(const TraceOpener& open, const std::string& dir, ns3::Ptr<ns3::QueueDisc> queue)
+    {
+        std::string unit =
+            queue->GetMaxSize().GetUnit() == ns3::QueueSizeUnit::BYTES ? "bytes" : "packets";
+        m_writer = open(dir + "queue-size", "queue-size", unit, "");
+    }
+
+    void Sample()
+    {
+        m_writer->Write(ns3::Simulator::Now().GetNanoSeconds(),
+                        m_queue->GetCurrentSize().GetValue());
+        ns3::Simulator::Schedule(m_interval, &QueueSizeTrace::Sample, this);
+    }
+
+    std::unique_ptr<TraceWriter> m_writer;
+    ns3::Ptr<ns3::QueueDisc> m_queue;
+    ns3::Time m_interval;
+};
+
+// Packets dropped by the bottleneck queue, in queueTraces/drop-0.dat
+class DropTrace
+{
+  public:
+    static constexpr bool enabled = true;
+
+    void Install(const TraceOpener& open, const std::string& dir, ns3::Ptr<ns3::QueueDisc> queue)
+    {
+        ns3::SystemPath::MakeDirectories(dir + "queueTraces/");
+        m_writer = open(dir + "queueTraces/drop-0", "drop", "packets", "");
+        queue->TraceConnectWithoutContext("Drop",
+                                          ns3::MakeBoundCallback(&DropTrace::Drop, m_writer.get()));
+    }
+
+    // After Simulator::Destroy()
+    void Finish()
+    {
+        if (m_writer)
+        {
+            m_writer->Close();
+        }
+    }
+
+  private:
+    static void Drop(TraceWriter* writer, ns3::Ptr<const ns3::QueueDiscItem> item)
+    {
+        writer->Write(ns3::Simulator::Now().GetNanoSeconds(), 1);
+    }
+
+    std::unique_ptr<TraceWriter> m_writer;
+};
+
+// cwnd and ssthresh (and for TcpBbr its state) of every BulkSend flow in
+// cwndTraces/, see FlowTracer
+class CwndTrace
+{
+  public:
+    static constexpr bool enabled = true;
+
+    // With cwndName and ssthreshName, the cwnd and ssthresh of all flows go
+    // to one text trace each under these names (FlowTracer::WriteMerged)
+    void Install(ns3::Time sampleInterval,
+                 uint32_t segmentSize,
+                 bool traceBbr,
+                 const std::string& cwndName = "",
+                 const std::string& ssthreshName = "")
+    {
+        m_tracer = std::make_unique<FlowTracer>(sampleInterval, segmentSize, traceBbr);
+        m_cwndName = cwndName;
+        m_ssthreshName = ssthreshName;
+    }
+
+    // Add the tracer to the observers of the BulkSend flows
+    void AddTo(std::vector<FlowObserver*>& observers)
+    {
+        if (m_tracer)
+        {
+            observers.push_back(m_tracer.get());
+        }
+    }
+
+    // At the end of the run
+    void Finish(const std::string& format, const std::string& dir)
+    {
+        if (m_tracer)
+        {
+            ns3::SystemPath::MakeDirectories(dir + "cwndTraces/");
+            if (m_cwndName.empty())
+            {
+                m_tracer->Write(format, dir + "cwndTraces/");
+            }
+            else
+            {
+                m_tracer->WriteMerged(format, dir + "cwndTraces/", m_cwndName, m_ssthreshName);
+            }
+        }
+    }
+
+    // Time per BBR state of every flow
+    void Write(std::ostream& os) const
+    {
+        if (m_tracer)
+        {
+            m_tracer->WriteBbrSummary(os);
+        }
+    }
+
+  private:
+    std::unique_ptr<FlowTracer> m_tracer;
+    std::string m_cwndName;
+    std::string m_ssthreshName;
+};
+
+// pcap of every point-to-point device in pcap/, snapped, sampled, rotated and
+// compressed as configured (see pcap-capture.h)
+class PcapTrace
+{
+  public:
+    static constexpr bool enabled = true;
+
+    void Install(const std::string& dir, const PcapCaptureConfig& config = PcapCaptureConfig())
+    {
+        ns3::SystemPath::MakeDirectories(dir + "pcap/");
+        m_capture = std::make_unique<PcapCapture>(config);
+        m_capture->InstallAll(dir + "pcap/ns-3");
+        m_capture->CloseOnDestroy();
+    }
+
+    // After Simulator::Destroy(), which has already written out the files
+    void Finish()
+    {
+        m_capture.reset();
+    }
+
+  private:
+    std::unique_ptr<PcapCapture> m_capture;
+};
+
+// Per-flow results from FlowMonitor on every node: bytes, packets, goodput,
+// retransmissions, and delay and jitter percentiles from its histograms
+class FlowMonitorStats
+{
+  public:
+    static constexpr bool enabled = true;
+
+    // histogramBinWidth is the bin width of the delay and jitter histograms
+    void Install(ns3::Time histogramBinWidth)
+    {
+        m_binWidth = histogramBinWidth.GetSeconds();
+        m_helper.SetMonitorAttribute("DelayBinWidth", ns3::DoubleValue(m_binWidth));
+        m_helper.SetMonitorAttribute("JitterBinWidth", ns3::DoubleValue(m_binWidth));
+        m_monitor = m_helper.InstallAll();
+    }
+
+    // One block per flow in os; the goodput of a flow is in decimal Mbps from
+    // its first packet until end. The compact delay and jitter histograms go
+    // to histograms, if given. Flows from or to skipPort (e.g. short flows,
+    // which report their completion times instead) are left out.
+    void Write(std::ostream& os, std::ostream* histograms, ns3::Time end, uint16_t skipPort = 0)
+    {
+        if (!m_monitor)
+        {
+            return;
+        }
+        m_monitor->CheckForLostPackets(); // Optional, helps in accounting for lost packets
+        ns3::Ptr<ns3::Ipv4FlowClassifier> classifier =
+            ns3::DynamicCast<ns3::Ipv4FlowClassifier>(m_helper.GetClassifier());
+        for (const auto& [id, stats] : m_monitor->GetFlowStats())
+        {
+            ns3::Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(id);
+            if (skipPort != 0 && (t.sourcePort == skipPort || t.destinationPort == skipPort))
+            {
+                continue;
+            }
+            os << "Flow " << id << " (" << t.sourceAddress << " -> " << t.destinationAddress
+               << ")\n";
+            os << "  Tx Bytes:   " << stats.txBytes << "\n";
+            os << "  Rx Bytes:   " << stats.rxBytes << "\n";
+            os << "  Tx Packets: " << stats.txPackets << "\n";
+            os << "  Rx Packets: " << stats.rxPackets << "\n";
+            os << "  Lost Packets: " << stats.lostPackets << "\n";
+            // Decimal Mbps over the time the flow was active
+            double activeSeconds = (end - stats.timeFirstTxPacket).GetSeconds();
+            os << "  Throughput: " << stats.rxBytes * 8.0 / activeSeconds / 1e6 << " Mbps\n";
+            // An estimate that can go below 0, so it must not wrap around
+            int64_t retransmissions =
+                int64_t(stats.txPackets) - stats.rxPackets - stats.lostPackets;
+            os << "  Retransmissions: " << retransmissions << "\n";
+            os << "  Average Delay: " << stats.delaySum.GetSeconds() / stats.rxPackets << "\n";
+            os << "  Delay p50/p90/p99/p99.9: ";
+            WriteHistogramPercentiles(os, stats.delayHistogram);
+            os << "\n  Jitter p50/p90/p99/p99.9: ";
+            WriteHistogramPercentiles(os, stats.jitterHistogram);
+            os << "\n";
+            if (histograms != nullptr)
+            {
+                WriteCompactHistogram(*histograms, id, t, "delay", m_binWidth, stats.delayHistogram);
+                WriteCompactHistogram(*histograms,
+                                      id,
+                                      t,
+                                      "jitter",
+                                      m_binWidth,
+                                      stats.jitterHistogram);
+            }
+        }
+    }
+
+  private:
+    ns3::FlowMonitorHelper m_helper;
+    ns3::Ptr<ns3::FlowMonitor> m_monitor;
+    double m_binWidth{0};
+};
+
+template <class Queue, class Drop, class Cwnd, class Pcap, class FlowStats>
+struct ScenarioTracers
+{
+    Queue queue;
+    Drop drop;
+    Cwnd cwnd;
+    Pcap pcap;
+    FlowStats flowStats;
+};
+
+// The tracers selected by the TCP_SCENARIO_* macros
+using ConfiguredTracers =
+    ScenarioTracers<std::conditional_t<TCP_SCENARIO_TRACE_QUEUE, QueueSizeTrace, NoTrace>,
+                    std::conditional_t<TCP_SCENARIO_TRACE_DROP, DropTrace, NoTrace>,
+                    std::conditional_t<TCP_SCENARIO_TRACE_CWND, CwndTrace, NoTrace>,
+                    std::conditional_t<TCP_SCENARIO_TRACE_PCAP, PcapTrace, NoTrace>,
+                    std::conditional_t<TCP_SCENARIO_FLOW_STATS, FlowMonitorStats, NoTrace>>;
+
+#endif /* TRACE_POLICIES_H */
@@ -0,0 +1,220 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+// Writers for the time series traces of the scenarios (queue-size.dat,
+// queueTraces/drop-0.dat, ...).
+//
+// This directory is header-only so that it can be shared by the scenarios
+// without being built as a program of its own: copy it into scratch/ next to
+// the scenario directories, e.g. scratch/tcp-scenario-common/.
+
+#include "ns3/abort.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Destination of a trace: a sequence of (timestamp, value) records
+class TraceWriter
+{
+  public:
+    virtual ~TraceWriter() = default;
+
+    // timeNs is the simulation time in nanoseconds
+    virtual void Write(int64_t timeNs, int64_t value) = 0;
+    // Write out anything still buffered and close the file
+    virtual void Close() = 0;
+};
+
+// The traditional "seconds value" text format of the .dat files, written
+// through a large buffer instead of flushing every line. suffix is appended to
+// every line, e.g. " 50000" for the port column of the cwnd traces.
+class TextTraceWriter : public TraceWriter
+{
+  public:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    explicit TextTraceWriter(const std::string& path, const std::string& suffix = "")
+        : m_buffer(BUFFER_SIZE),
+          m_suffix(suffix)
+    {
+        m_out.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+        m_out.open(path, std::ios::out);
+        NS_ABORT_MSG_UNLESS(m_out.is_open(), "Cannot write trace " << path);
+    }
+
+    ~TextTraceWriter() override
+    {
+        Close();
+    }
+
+    void Write(int64_t timeNs, int64_t value) override
+    {
+        m_out << timeNs / 1e9 << " " << value << m_suffix << "\n";
+    }
+
+    void Close() override
+    {
+        if (m_out.is_open())
+        {
+            m_out.close();
+        }
+    }
+
+  private:
+    std::vector<char> m_buffer;
+    std::string m_suffix;
+    std::ofstream m_out;
+};
+
+// Self-describing header of a binary trace, 64 bytes. Every integer in the
+// file is little-endian, whatever the byte order of the machine.
+struct BinaryTraceHeader
+{
+    char magic[8];       // "NS3TRACE"
+    uint32_t version;    // 2
+    uint32_t headerSize; // offset of the first record
+    uint32_t recordSize; // 0: records are variable-length
+    uint32_t reserved;
+    char name[20]; // what is traced, e.g. "queue-size"
+    char unit[20]; // unit of the value, e.g. "bytes"
+};
+
+static_assert(sizeof(BinaryTraceHeader) == 64, "BinaryTraceHeader must be 64 bytes");
+
+// One (timestamp, value) record, as queued by AsyncTraceWriter
+struct BinaryTraceRecord
+{
+    int64_t timeNs;
+    int64_t value;
+};
+
+// Compact binary format: a BinaryTraceHeader followed by one record per
+// sample, each the change of the timestamp and then of the value since the
+// previous record (both starting from 0), zigzag-encoded and written as
+// LEB128 varints. A queue sample every millisecond takes 3 bytes for the time
+// and 1 to 3 for the value, against 10 to 16 characters for a line of the
+// text format. Records are encoded into a large buffer and written out in one
+// call when it is full. Use bintrace.py to read the file or convert it back
+// to .dat text.
+class BinaryTraceWriter : public TraceWriter
+{
+  public:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    BinaryTraceWriter(const std::string& path, const std::string& name, const std::string& unit)
+        : m_path(path)
+    {
+        m_buffer.reserve(BUFFER_SIZE + 2 * MAX_VARINT);
+        m_file = std::fopen(path.c_str(), "wb");
+        NS_ABORT_MSG_UNLESS(m_file != nullptr, "Cannot write trace " << path);
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+        char text[20];
+        m_buffer.insert(m_buffer.end(), MAGIC, MAGIC + 8);
+        PutUint32(2);
+        PutUint32(sizeof(BinaryTraceHeader));
+        PutUint32(0);
+        PutUint32(0);
+        for (const std::string& field : {name, unit})
+        {
+            std::memset(text, 0, sizeof(text));
+            std::strncpy(text, field.c_str(), sizeof(text) - 1);
+            m_buffer.insert(m_buffer.end(), text, text + sizeof(text));
+        }
+    }
+
+    ~BinaryTraceWriter() override
+    {
+        Close();
+    }
+
+    void Write(int64_t timeNs, int64_t value) override
+    {
+        PutVarint(ZigZag(timeNs - m_lastTimeNs));
+        PutVarint(ZigZag(value - m_lastValue));
+        m_lastTimeNs = timeNs;
+        m_lastValue = value;
+        if (m_buffer.size() >= BUFFER_SIZE)
+        {
+            Flush();
+        }
+    }
+
+    void Close() override
+    {
+        if (m_file != nullptr)
+        {
+            Flush();
+            int closed = std::fclose(m_file);
+            m_file = nullptr;
+            NS_ABORT_MSG_UNLESS(closed == 0, "Cannot write trace " << m_path);
+        }
+    }
+
+  private:
+    static constexpr char MAGIC[] = "NS3TRACE";
+    static constexpr std::size_t MAX_VARINT = 10;
+
+    static uint64_t ZigZag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    void PutUint32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            m_buffer.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+
+    void PutVarint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            m_buffer.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        m_buffer.push_back(static_cast<uint8_t>(v));
+    }
+
+    void Flush()
+    {
+        if (m_file != nullptr && !m_buffer.empty())
+        {
+            // A full disk must not silently truncate the trace
+            std::size_t written = std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+            NS_ABORT_MSG_UNLESS(written == m_buffer.size(), "Cannot write trace " << m_path);
+        }
+        m_buffer.clear();
+    }
+
+    std::string m_path;
+    std::FILE* m_file{nullptr};
+    std::vector<uint8_t> m_buffer;
+    int64_t m_lastTimeNs{0};
+    int64_t m_lastValue{0};
+};
+
+// Open the trace basePath.dat (format "text") or basePath.bin (format "binary").
+// textSuffix only applies to the text format.
+inline std::unique_ptr<TraceWriter>
+CreateTraceWriter(const std::string& format,
+                  const std::string& basePath,
+                  const std::string& name,
+                  const std::string& unit,
+                  const std::string& textSuffix = "")
+{
+    if (format == "binary")
+    {
+        return std::make_unique<BinaryTraceWriter>(basePath + ".bin", name, unit);
+    }
+    return std::make_unique<TextTraceWriter>(basePath + ".dat", textSuffix);
+}
+
+#endif /* TRACE_WRITER_H */